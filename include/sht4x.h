@@ -46,7 +46,20 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "sdkconfig.h"
+#if CONFIG_SHT4X_I2C_MASTER
 #include "driver/i2c_master.h"
+#endif
+#include "esp_attr.h"
+#include "esp_timer.h"
+#if CONFIG_SHT4X_PM_LOCK
+#include "esp_pm.h"
+#endif
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "sht4x_filter.h"
 
 /* Exported Macros -----------------------------------------------------------*/
 #define SHT40_I2C_ADDR_44	0x44
@@ -56,6 +69,19 @@ extern "C" {
 #define SHT45_I2C_ADDR_44	0x44
 #define SHT45_I2C_ADDR_45	0x45
 
+/* Placement of the CRC and conversion routines */
+#if CONFIG_SHT4X_IRAM_SAFE
+#define SHT4X_IRAM_ATTR	IRAM_ATTR
+#define SHT4X_DRAM_ATTR	DRAM_ATTR
+#else
+#define SHT4X_IRAM_ATTR
+#define SHT4X_DRAM_ATTR
+#endif
+
+/* I2C general call */
+#define SHT4X_GENERAL_CALL_ADDR		0x00
+#define SHT4X_GENERAL_CALL_RESET	0x06
+
 /* SHT4x commands */
 #define SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD							0xFD
 #define SHT4X_MEASURE_MEDIUM_PRECISION_TICKS_CMD						0xF6
@@ -69,16 +95,161 @@ extern "C" {
 #define SHT4X_SERIAL_NUMBER_CMD															0x89
 #define SHT4X_SOFT_RESET_CMD																0x94
 
+/* SHT4x error codes */
+#define SHT4X_ERR_NACK		ESP_ERR_NOT_FOUND		/*!< The sensor did not acknowledge */
+#define SHT4X_ERR_TIMEOUT	ESP_ERR_TIMEOUT			/*!< The I2C transaction timed out */
+#define SHT4X_ERR_CRC			ESP_ERR_INVALID_CRC	/*!< The response CRC does not match */
+
+/* SHT4x record flags */
+#define SHT4X_RECORD_FLAG_HEATER						(1 << 0)	/*!< Measured at the end of a heater pulse */
+#define SHT4X_RECORD_FLAG_HEATER_RECOVERY	(1 << 1)	/*!< Measured while the sensor cools down after a heater pulse */
+
+#define SHT4X_CONFIG_DEFAULT(addr) {													\
+		.dev_addr = (addr),																		\
+		.scl_speed_hz = CONFIG_SHT4X_I2C_SCL_SPEED_HZ,				\
+		.scl_wait_us = 0,																			\
+		.timeout_ms = CONFIG_SHT4X_I2C_TIMEOUT_MS,						\
+		.poll_interval_us = CONFIG_SHT4X_NACK_POLL_INTERVAL_US	\
+}
+
 /* Exported typedef ----------------------------------------------------------*/
+typedef enum {
+	SHT4X_WAIT_MODE_BUSY = 0,	/*!< Spin on esp_timer_get_time() */
+	SHT4X_WAIT_MODE_DELAY,		/*!< Block the calling task with vTaskDelay() */
+	SHT4X_WAIT_MODE_TIMER,		/*!< Block on a semaphore given by an esp_timer */
+	SHT4X_WAIT_MODE_LIGHT_SLEEP	/*!< Light sleep the chip with a timer wakeup */
+} sht4x_wait_mode_t;
+
 typedef struct {
-	i2c_master_dev_handle_t i2c_dev;	/*!< I2C device handle */
+	int64_t timestamp_us;	/*!< Time at which the result was read */
+	uint16_t temp_ticks;	/*!< Temperature ticks */
+	uint16_t hum_ticks;		/*!< Humidity ticks */
+	esp_err_t status;			/*!< Result of the measurement */
+	uint8_t flags;				/*!< SHT4X_RECORD_FLAG_* bits */
+} sht4x_record_t;
+
+typedef struct {
+	uint8_t data[6];	/*!< Raw response: word, CRC, word, CRC */
+} sht4x_frame_t;
+
+typedef struct {
+	uint32_t transactions;		/*!< I2C transactions */
+	uint32_t polls;						/*!< Reads NACKed because the result was not ready yet */
+	uint64_t bus_time_us;			/*!< Time spent in I2C transactions */
+	uint64_t wait_time_us;		/*!< Time spent waiting for conversions */
+	uint32_t commands;				/*!< Successful sht4x_execute() calls */
+	uint32_t latency_min_us;	/*!< Minimum sht4x_execute() latency */
+	uint32_t latency_max_us;	/*!< Maximum sht4x_execute() latency */
+	uint32_t latency_avg_us;	/*!< Average sht4x_execute() latency */
+	uint64_t latency_sum_us;	/*!< Sum of the sht4x_execute() latencies */
+	uint32_t crc_errors;			/*!< Responses with a wrong CRC */
+	uint32_t nack_errors;			/*!< Transactions failed with SHT4X_ERR_NACK */
+	uint32_t timeout_errors;	/*!< Transactions failed with SHT4X_ERR_TIMEOUT */
+	uint32_t wait_fallbacks;	/*!< Waits that spun because the wait timer could not be armed */
+} sht4x_stats_t;
+
+typedef struct {
+	uint8_t dev_addr;						/*!< I2C device address */
+	uint32_t scl_speed_hz;			/*!< SCL frequency, up to 1 MHz */
+	uint32_t scl_wait_us;				/*!< Clock stretching timeout, 0 for the driver default */
+	int timeout_ms;							/*!< Timeout of every I2C transaction, -1 to wait forever */
+	uint32_t poll_interval_us;	/*!< Initial NACK polling interval, 0 to disable */
+} sht4x_config_t;
+
+typedef esp_err_t (*sht4x_read_fptr_t)(uint8_t reg_addr, uint8_t *reg_data,
+		                                   uint32_t data_len, void *intf);
+typedef esp_err_t (*sht4x_write_fptr_t)(uint8_t reg_addr,
+		                                    const uint8_t *reg_data,
+		                                    uint32_t data_len, void *intf);
+
+typedef struct {
+	sht4x_read_fptr_t read;		/*!< Reads data_len bytes, SHT4X_ERR_NACK while the sensor is busy */
+	sht4x_write_fptr_t write;	/*!< Writes the command byte reg_addr */
+	void *intf;								/*!< Argument passed to read and write */
+} sht4x_transport_t;
+
+typedef void (*sht4x_async_cb_t)(const sht4x_record_t *record, void *arg);
+
+typedef struct {
+#if CONFIG_SHT4X_I2C_MASTER
+	i2c_master_dev_handle_t i2c_dev;	/*!< I2C device handle, NULL on a custom transport */
+	i2c_master_bus_handle_t i2c_bus;	/*!< I2C bus the device was added to */
+	i2c_device_config_t i2c_dev_conf;	/*!< Configuration the device was added with */
+#endif
+	sht4x_transport_t transport;			/*!< Bus transport */
+	int timeout_ms;										/*!< Timeout of every I2C transaction, -1 to wait forever */
+	uint32_t poll_interval_us;				/*!< Initial NACK polling interval, 0 to disable */
+	sht4x_wait_mode_t wait_mode;			/*!< Conversion wait mode */
+	esp_timer_handle_t wait_timer;		/*!< One-shot timer used by SHT4X_WAIT_MODE_TIMER */
+	SemaphoreHandle_t wait_sem;				/*!< Semaphore given by wait_timer */
+#if CONFIG_SHT4X_PM_LOCK
+	esp_pm_lock_handle_t pm_lock;			/*!< APB frequency lock held during bus phases */
+#endif
+	uint8_t pending_cmd;							/*!< Command started by sht4x_start_measurement() */
+	bool pending;											/*!< True while a result is waiting to be read */
+	int64_t ready_time_us;						/*!< Time at which the pending result is ready */
+	uint8_t result_flags;							/*!< SHT4X_RECORD_FLAG_* bits of the last result read */
+	int64_t heater_ready_us;					/*!< Earliest start of the next heater pulse */
+	int64_t heater_recovery_us;				/*!< End of the recovery after the last heater pulse */
+	uint32_t serial_number;						/*!< Serial number read from the sensor */
+	bool serial_valid;								/*!< True once serial_number has been read */
+	bool async_enabled;								/*!< True while the I2C device is in asynchronous mode */
+	volatile uint32_t async_state;		/*!< State of the asynchronous measurement */
+	uint8_t async_cmd;								/*!< Command of the asynchronous measurement */
+	uint32_t async_wait_us;						/*!< Execution time of async_cmd, precomputed for the ISR */
+	uint8_t async_rx_len;							/*!< Response length of async_cmd */
+	uint8_t async_flags;							/*!< SHT4X_RECORD_FLAG_* bits of the asynchronous result */
+	sht4x_frame_t async_frame;				/*!< Response of the asynchronous measurement */
+	esp_timer_handle_t async_timer;		/*!< Timer of the asynchronous conversion wait */
+	sht4x_async_cb_t async_cb;				/*!< Callback of the asynchronous measurement */
+	void *async_cb_arg;								/*!< Argument passed to async_cb */
+#if CONFIG_SHT4X_FILTER
+	sht4x_filter_t temp_filter;				/*!< Temperature filter of sht4x_measure_filtered() */
+	sht4x_filter_t hum_filter;				/*!< Humidity filter of sht4x_measure_filtered() */
+#endif
+#if CONFIG_SHT4X_STATS
+	sht4x_stats_t stats;							/*!< Statistics, read with sht4x_get_stats() */
+	portMUX_TYPE stats_lock;					/*!< Spinlock protecting stats */
+#endif
+#if CONFIG_SHT4X_THREAD_SAFE
+	SemaphoreHandle_t lock;						/*!< Mutex held during the bus phases of a command */
+	SemaphoreHandle_t done_sem;				/*!< Counting semaphore given to every waiter when a command ends */
+	TaskHandle_t owner;								/*!< Task owning the command in flight, NULL if idle */
+	uint16_t waiters;									/*!< Tasks waiting on done_sem */
+	uint32_t done_seq;								/*!< Number of commands ended */
+	uint8_t done_cmd;									/*!< Last ended command */
+	esp_err_t done_status;						/*!< Result of the last ended command */
+	sht4x_frame_t done_frame;					/*!< Response of the last ended command */
+#endif
+#if CONFIG_SHT4X_RESULT_CACHE
+	sht4x_record_t cache;							/*!< Last measurement result */
+	uint8_t cache_cmd;								/*!< Command of the cached result, 0 if empty */
+	portMUX_TYPE cache_lock;					/*!< Spinlock protecting cache and cache_cmd */
+	SemaphoreHandle_t cache_mutex;		/*!< Mutex held by the sht4x_measure_cached() caller converting */
+#endif
 } sht4x_t;
 
 /* Exported variables --------------------------------------------------------*/
 
+/* Inline functions ----------------------------------------------------------*/
+/**
+ * @brief Function to assemble the serial number from the two words of the
+ * SHT4X_SERIAL_NUMBER_CMD response
+ *
+ * @param high_word : First word of the response
+ * @param low_word  : Second word of the response
+ *
+ * @return Serial number
+ */
+static inline uint32_t sht4x_serial_number_from_words(uint16_t high_word,
+		                                                  uint16_t low_word) {
+	return ((uint32_t)high_word << 16) | low_word;
+}
+
 /* Exported functions prototypes ---------------------------------------------*/
+#if CONFIG_SHT4X_I2C_MASTER
 /**
- * @brief Function to initialize a SHT4x instance
+ * @brief Function to initialize a SHT4x instance with SHT4X_CONFIG_DEFAULT()
  *
  * @param me       : Pointer to a sht4x_t instance
  * @param i2c_bus  : Pointer to a structure with the data to initialize the
@@ -90,6 +261,330 @@ typedef struct {
 esp_err_t sht4x_init(sht4x_t *const me, i2c_master_bus_handle_t i2c_bus_handle,
 		uint8_t dev_addr);
 
+/**
+ * @brief Function to initialize a SHT4x instance with a custom bus
+ * configuration. Queue depth is a property of the whole bus, set it in the
+ * i2c_master_bus_config_t of the bus.
+ *
+ * @param me             : Pointer to a sht4x_t instance
+ * @param i2c_bus_handle : I2C bus handle
+ * @param config         : Device configuration, see SHT4X_CONFIG_DEFAULT()
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sht4x_init_with_config(sht4x_t *const me,
+		                             i2c_master_bus_handle_t i2c_bus_handle,
+		                             const sht4x_config_t *config);
+
+/**
+ * @brief Function to find the fastest SCL frequency at which the sensor
+ * answers reliably. Every candidate is tried, fastest first, with CRC-verified
+ * serial number reads. The instance keeps the selected frequency, or its
+ * previous one if no candidate passes.
+ *
+ * @param me          : Pointer to a sht4x_t instance initialized on an I2C bus
+ * @param speeds_hz   : Candidate SCL frequencies
+ * @param speeds_num  : Number of candidates
+ * @param attempts    : Reads that must succeed at a frequency
+ * @param speed_hz    : Pointer to store the selected frequency. Can be NULL
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no candidate passes,
+ * ESP_ERR_NOT_SUPPORTED on a custom transport, ESP_ERR_INVALID_STATE in
+ * asynchronous mode, an error code otherwise
+ */
+esp_err_t sht4x_probe_speed(sht4x_t *const me, const uint32_t *speeds_hz,
+		                        size_t speeds_num, uint32_t attempts,
+		                        uint32_t *speed_hz);
+#endif /* CONFIG_SHT4X_I2C_MASTER */
+
+/**
+ * @brief Function to initialize a SHT4x instance on a custom transport, e.g.
+ * a simulated sensor or another bus driver. Asynchronous mode is not
+ * available on custom transports.
+ *
+ * @param me        : Pointer to a sht4x_t instance
+ * @param transport : Transport functions, copied into the instance
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sht4x_init_with_transport(sht4x_t *const me,
+		                                const sht4x_transport_t *transport);
+
+/**
+ * @brief Function to deinitialize a SHT4x instance
+ *
+ * @param me : Pointer to a sht4x_t instance
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sht4x_deinit(sht4x_t *const me);
+
+/**
+ * @brief Function to select how the driver waits for the sensor to finish a
+ * command.
+ *
+ * @param me        : Pointer to a sht4x_t instance
+ * @param wait_mode : Wait mode. Waits shorter than
+ *                    CONFIG_SHT4X_WAIT_SPIN_THRESHOLD_US are always spun
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+esp_err_t sht4x_set_wait_mode(sht4x_t *const me, sht4x_wait_mode_t wait_mode);
+
+/**
+ * @brief Function to set the timeout of every I2C transaction. The default is
+ * CONFIG_SHT4X_I2C_TIMEOUT_MS.
+ *
+ * @param me         : Pointer to a sht4x_t instance
+ * @param timeout_ms : Timeout in ms, -1 to wait forever
+ */
+void sht4x_set_timeout(sht4x_t *const me, int timeout_ms);
+
+/**
+ * @brief Function to enable or disable NACK polling in sht4x_execute(). When
+ * enabled the result is read as soon as the sensor finishes: the first read
+ * attempt is at the typical execution time, then the sensor is polled with an
+ * interval that doubles after every NACK until the maximum execution time.
+ * The default is CONFIG_SHT4X_NACK_POLL_INTERVAL_US.
+ *
+ * @param me          : Pointer to a sht4x_t instance
+ * @param interval_us : Initial polling interval in us, 0 to disable
+ */
+void sht4x_set_poll_interval(sht4x_t *const me, uint32_t interval_us);
+
+/**
+ * @brief Function to get the time the sensor needs to execute a command,
+ * including CONFIG_SHT4X_TIMING_MARGIN_PERCENT.
+ *
+ * @param cmd : Command byte, one of the SHT4X_*_CMD macros
+ *
+ * @return Execution time in us, 0 for unknown commands
+ */
+uint32_t sht4x_get_command_duration_us(uint8_t cmd);
+
+/**
+ * @brief Function to get the typical time the sensor needs to execute a
+ * command, without any margin.
+ *
+ * @param cmd : Command byte, one of the SHT4X_*_CMD macros
+ *
+ * @return Typical execution time in us, 0 for unknown commands
+ */
+uint32_t sht4x_get_command_typical_us(uint8_t cmd);
+
+/**
+ * @brief Function to know whether a command turns the heater on
+ *
+ * @param cmd : Command byte, one of the SHT4X_*_CMD macros
+ *
+ * @return True for the heater commands compiled in, False otherwise
+ */
+bool sht4x_is_heater_command(uint8_t cmd);
+
+/**
+ * @brief Function to send a command without waiting for its result. The result
+ * is read later with sht4x_read_result(). With CONFIG_SHT4X_THREAD_SAFE the
+ * caller first waits for a command started by another task to end.
+ *
+ * @param me            : Pointer to a sht4x_t instance
+ * @param cmd           : Command byte, one of the SHT4X_*_CMD macros
+ * @param ready_time_us : Time, in esp_timer_get_time() units, at which the
+ *                        result is ready. Can be NULL
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if a heater command comes
+ * before sht4x_get_heater_ready_time(), an error code otherwise
+ */
+esp_err_t sht4x_start_measurement(sht4x_t *const me, uint8_t cmd,
+		                              int64_t *ready_time_us);
+
+/**
+ * @brief Function to read the result of the command sent by
+ * sht4x_start_measurement().
+ *
+ * @param me         : Pointer to a sht4x_t instance
+ * @param poll       : If true and the result is not due yet, try to read it
+ *                     anyway. The sensor NACKs the read while it is busy
+ * @param temp_ticks : First word of the response (temperature ticks)
+ * @param hum_ticks  : Second word of the response (humidity ticks)
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FINISHED if the result is not ready
+ * yet, ESP_ERR_INVALID_STATE if there is no pending command, SHT4X_ERR_NACK,
+ * SHT4X_ERR_TIMEOUT or SHT4X_ERR_CRC on failure
+ */
+esp_err_t sht4x_read_result(sht4x_t *const me, bool poll, uint16_t *temp_ticks,
+		                        uint16_t *hum_ticks);
+
+/**
+ * @brief Function to read the raw response of the command sent by
+ * sht4x_start_measurement(). The CRC is not checked.
+ *
+ * @param me    : Pointer to a sht4x_t instance
+ * @param poll  : If true and the result is not due yet, try to read it anyway
+ * @param frame : Raw response
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FINISHED if the result is not ready
+ * yet, ESP_ERR_INVALID_STATE if there is no pending command, an error code
+ * otherwise
+ */
+esp_err_t sht4x_read_frame(sht4x_t *const me, bool poll, sht4x_frame_t *frame);
+
+/**
+ * @brief Function to perform back-to-back measurements into an array of
+ * records. The ticks are not converted.
+ *
+ * @param me          : Pointer to a sht4x_t instance
+ * @param cmd         : Measurement command
+ * @param records     : Array of records to fill
+ * @param records_num : Number of records to fill
+ *
+ * @return ESP_OK if every measurement succeeded, ESP_FAIL otherwise. The
+ * status of each measurement is in its record
+ */
+esp_err_t sht4x_measure_records(sht4x_t *const me, uint8_t cmd,
+		                            sht4x_record_t *records, size_t records_num);
+
+/**
+ * @brief Function to perform back-to-back measurements into an array of raw
+ * frames. The CRC is not checked.
+ *
+ * @param me         : Pointer to a sht4x_t instance
+ * @param cmd        : Command byte, one of the SHT4X_*_CMD macros
+ * @param frames     : Array of frames to fill
+ * @param frames_num : Number of frames to fill
+ *
+ * @return ESP_OK on success, an error code otherwise. Stops at the first error
+ */
+esp_err_t sht4x_measure_frames(sht4x_t *const me, uint8_t cmd,
+		                           sht4x_frame_t *frames, size_t frames_num);
+
+/**
+ * @brief Function to get the SHT4X_RECORD_FLAG_* bits of the last result
+ * read, e.g. to mark a record built from sht4x_read_result()
+ *
+ * @param me : Pointer to a sht4x_t instance
+ *
+ * @return SHT4X_RECORD_FLAG_* bits
+ */
+uint8_t sht4x_get_result_flags(const sht4x_t *me);
+
+/**
+ * @brief Function to get the earliest time a heater command is accepted
+ * without exceeding CONFIG_SHT4X_HEATER_MAX_DUTY_PERCENT
+ *
+ * @param me : Pointer to a sht4x_t instance
+ *
+ * @return Time in esp_timer_get_time() units
+ */
+int64_t sht4x_get_heater_ready_time(const sht4x_t *me);
+
+/**
+ * @brief Function to wait, using the instance wait mode, until a given time.
+ *
+ * @param me      : Pointer to a sht4x_t instance
+ * @param time_us : Time in esp_timer_get_time() units, e.g. the ready time
+ *                  returned by sht4x_start_measurement()
+ */
+void sht4x_wait_until(sht4x_t *const me, int64_t time_us);
+
+/**
+ * @brief Function to execute any command: send it, wait for it to finish
+ * using the instance wait mode and read its response, if any. With
+ * CONFIG_SHT4X_THREAD_SAFE a measurement already in flight from another task
+ * with the same command is shared instead of started again.
+ *
+ * @param me         : Pointer to a sht4x_t instance
+ * @param cmd        : Command byte, one of the SHT4X_*_CMD macros
+ * @param temp_ticks : First word of the response (temperature ticks). Can be
+ *                     NULL
+ * @param hum_ticks  : Second word of the response (humidity ticks). Can be
+ *                     NULL
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if a heater command comes
+ * before sht4x_get_heater_ready_time(), an error code otherwise
+ */
+esp_err_t sht4x_execute(sht4x_t *const me, uint8_t cmd, uint16_t *temp_ticks,
+		                    uint16_t *hum_ticks);
+
+/**
+ * @brief Function to perform several back-to-back conversions and average
+ * their ticks, e.g. to replace one high precision conversion by a few lowest
+ * precision ones
+ *
+ * @param me      : Pointer to a sht4x_t instance
+ * @param cmd     : Measurement command byte, one of the SHT4X_MEASURE_*_CMD
+ *                  macros
+ * @param samples : Number of conversions, 1 to 256
+ * @param record  : Pointer to store the averaged result, timestamped at the
+ *                  last conversion
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if samples is out of range,
+ * the error of the first failed conversion otherwise
+ */
+esp_err_t sht4x_oversample(sht4x_t *const me, uint8_t cmd, size_t samples,
+		                       sht4x_record_t *record);
+
+#if CONFIG_SHT4X_FILTER
+/**
+ * @brief Function to select the filter of both channels of
+ * sht4x_measure_filtered() and discard their history. Filters start as
+ * SHT4X_FILTER_NONE.
+ *
+ * @param me    : Pointer to a sht4x_t instance
+ * @param type  : Filter type
+ * @param param : Window length or EMA shift, see sht4x_filter_init()
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if param is out of range
+ */
+esp_err_t sht4x_set_filter(sht4x_t *const me, sht4x_filter_type_t type,
+		                       uint8_t param);
+
+/**
+ * @brief Function to execute a measurement command and feed its ticks to the
+ * instance filters. Failed conversions leave the filters untouched.
+ *
+ * @param me     : Pointer to a sht4x_t instance
+ * @param cmd    : Measurement command byte, one of the SHT4X_MEASURE_*_CMD
+ *                 macros
+ * @param record : Pointer to store the filtered result
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+esp_err_t sht4x_measure_filtered(sht4x_t *const me, uint8_t cmd,
+		                             sht4x_record_t *record);
+#endif /* CONFIG_SHT4X_FILTER */
+
+#if CONFIG_SHT4X_MILLI_API
+/**
+ * @brief Function to execute a measurement command and convert the result to
+ * thousandths of a degree centigrade and thousandths of a percent relative
+ * humidity.
+ *
+ * @param me   : Pointer to a sht4x_t instance
+ * @param cmd  : Measurement or heater command
+ * @param temp : Temperature in thousandths of a degree centigrade.
+ * @param hum  : Humidity in thousandths of a percent relative humidity.
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+esp_err_t sht4x_measure_milli(sht4x_t *const me, uint8_t cmd, int32_t *temp,
+		                          int32_t *hum);
+#endif /* CONFIG_SHT4X_MILLI_API */
+
+#if CONFIG_SHT4X_FLOAT_API
+/**
+ * @brief Function to execute a measurement command and convert the result to
+ * degrees centigrade and percent relative humidity.
+ *
+ * @param me   : Pointer to a sht4x_t instance
+ * @param cmd  : Measurement or heater command
+ * @param temp : Temperature in degrees centigrade.
+ * @param hum  : Humidity in percent relative humidity.
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+esp_err_t sht4x_measure(sht4x_t *const me, uint8_t cmd, float *temp,
+		                    float *hum);
+
 /**
  * @brief Function for a single shot measurement with high repeatability.
  *
@@ -99,9 +594,14 @@ esp_err_t sht4x_init(sht4x_t *const me, i2c_master_bus_handle_t i2c_bus_handle,
  *
  * @return 0 on success, an error code otherwise
  */
-esp_err_t sht4x_measure_high_precision(sht4x_t *const me, float *temperature,
-		                                   float *humidity);
+static inline esp_err_t sht4x_measure_high_precision(sht4x_t *const me,
+		                                                 float *temperature,
+		                                                 float *humidity) {
+	return sht4x_measure(me, SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD,
+			temperature, humidity);
+}
 
+#if CONFIG_SHT4X_MEDIUM_PRECISION
 /**
  * @brief Function for a single shot measurement with medium repeatability.
  *
@@ -111,9 +611,15 @@ esp_err_t sht4x_measure_high_precision(sht4x_t *const me, float *temperature,
  *
  * @return 0 on success, an error code otherwise
  */
-esp_err_t sht4x_measure_medium_precision(sht4x_t *const me, float *temperature,
-		                                     float *humidity);
+static inline esp_err_t sht4x_measure_medium_precision(sht4x_t *const me,
+		                                                   float *temperature,
+		                                                   float *humidity) {
+	return sht4x_measure(me, SHT4X_MEASURE_MEDIUM_PRECISION_TICKS_CMD,
+			temperature, humidity);
+}
+#endif /* CONFIG_SHT4X_MEDIUM_PRECISION */
 
+#if CONFIG_SHT4X_LOWEST_PRECISION
 /**
  * @brief Function for a single shot measurement with lowest repeatability.
  *
@@ -123,9 +629,15 @@ esp_err_t sht4x_measure_medium_precision(sht4x_t *const me, float *temperature,
  *
  * @return 0 on success, an error code otherwise
  */
-esp_err_t sht4x_measure_lowest_precision(sht4x_t *const me, float *temperature,
-		                                     float *humidity);
+static inline esp_err_t sht4x_measure_lowest_precision(sht4x_t *const me,
+		                                                   float *temperature,
+		                                                   float *humidity) {
+	return sht4x_measure(me, SHT4X_MEASURE_LOWEST_PRECISION_TICKS_CMD,
+			temperature, humidity);
+}
+#endif /* CONFIG_SHT4X_LOWEST_PRECISION */
 
+#if CONFIG_SHT4X_HEATER
 /**
  * @brief Function to activate highest heater power and perform a single
  * shot high precision measurement for 1s.
@@ -136,9 +648,12 @@ esp_err_t sht4x_measure_lowest_precision(sht4x_t *const me, float *temperature,
  *
  * @return 0 on success, an error code otherwise
  */
-esp_err_t sht4x_activate_highest_heater_power_long(sht4x_t *const me,
-		                                               float *temperature,
-																									 float *humidity);
+static inline esp_err_t sht4x_activate_highest_heater_power_long(sht4x_t *const me,
+		                                                             float *temperature,
+		                                                             float *humidity) {
+	return sht4x_measure(me, SHT4X_ACTIVATE_HIGHEST_HEATER_POWER_LONG_TICKS_CMD,
+			temperature, humidity);
+}
 
 /**
  * @brief Function to activate highest heater power and perform a single
@@ -150,9 +665,12 @@ esp_err_t sht4x_activate_highest_heater_power_long(sht4x_t *const me,
  *
  * @return 0 on success, an error code otherwise
  */
-esp_err_t sht4x_activate_highest_heater_power_short(sht4x_t *const me,
-		                                                float *temperature,
-																										float *humidity);
+static inline esp_err_t sht4x_activate_highest_heater_power_short(sht4x_t *const me,
+		                                                              float *temperature,
+		                                                              float *humidity) {
+	return sht4x_measure(me, SHT4X_ACTIVATE_HIGHEST_HEATER_POWER_SHORT_TICKS_CMD,
+			temperature, humidity);
+}
 
 /**
  * @brief Function to activate medium heater power and perform a single
@@ -164,9 +682,12 @@ esp_err_t sht4x_activate_highest_heater_power_short(sht4x_t *const me,
  *
  * @return 0 on success, an error code otherwise
  */
-esp_err_t sht4x_activate_medium_heater_power_long(sht4x_t *const me,
-		                                              float *temperature,
-																									float *humidity);
+static inline esp_err_t sht4x_activate_medium_heater_power_long(sht4x_t *const me,
+		                                                            float *temperature,
+		                                                            float *humidity) {
+	return sht4x_measure(me, SHT4X_ACTIVATE_MEDIUM_HEATER_POWER_LONG_TICKS_CMD,
+			temperature, humidity);
+}
 
 /**
  * @brief Function to activate medium heater power and perform a single
@@ -178,9 +699,12 @@ esp_err_t sht4x_activate_medium_heater_power_long(sht4x_t *const me,
  *
  * @return 0 on success, an error code otherwise
  */
-esp_err_t sht4x_activate_medium_heater_power_short(sht4x_t *const me,
-		                                               float *temperature,
-																									 float *humidity);
+static inline esp_err_t sht4x_activate_medium_heater_power_short(sht4x_t *const me,
+		                                                             float *temperature,
+		                                                             float *humidity) {
+	return sht4x_measure(me, SHT4X_ACTIVATE_MEDIUM_HEATER_POWER_SHORT_TICKS_CMD,
+			temperature, humidity);
+}
 
 /**
  * @brief Function to activate lowest heater power and perform a single
@@ -192,9 +716,12 @@ esp_err_t sht4x_activate_medium_heater_power_short(sht4x_t *const me,
  *
  * @return 0 on success, an error code otherwise
  */
-esp_err_t sht4x_activate_lowest_heater_power_long(sht4x_t *const me,
-		                                              float *temperature,
-																									float *humidity);
+static inline esp_err_t sht4x_activate_lowest_heater_power_long(sht4x_t *const me,
+		                                                            float *temperature,
+		                                                            float *humidity) {
+	return sht4x_measure(me, SHT4X_ACTIVATE_LOWEST_HEATER_POWER_LONG_TICKS_CMD,
+			temperature, humidity);
+}
 
 /**
  * @brief Function to activate lowest heater power and perform a single
@@ -206,9 +733,68 @@ esp_err_t sht4x_activate_lowest_heater_power_long(sht4x_t *const me,
  *
  * @return 0 on success, an error code otherwise
  */
-esp_err_t sht4x_activate_lowest_heater_power_short(sht4x_t *const me,
-		                                               float *temperature,
-																									 float *humidity);
+static inline esp_err_t sht4x_activate_lowest_heater_power_short(sht4x_t *const me,
+		                                                             float *temperature,
+		                                                             float *humidity) {
+	return sht4x_measure(me, SHT4X_ACTIVATE_LOWEST_HEATER_POWER_SHORT_TICKS_CMD,
+			temperature, humidity);
+}
+#endif /* CONFIG_SHT4X_HEATER */
+#endif /* CONFIG_SHT4X_FLOAT_API */
+
+#if CONFIG_SHT4X_MILLI_API
+/**
+ * @brief Function for a single shot measurement with high repeatability.
+ *
+ * @param me   : Pointer to a sht4x_t instance
+ * @param temp : Temperature in thousandths of a degree centigrade.
+ * @param hum  : Humidity in thousandths of a percent relative humidity.
+ *
+ * @return 0 on success, an error code otherwise
+ */
+static inline esp_err_t sht4x_measure_high_precision_milli(sht4x_t *const me,
+		                                                       int32_t *temperature,
+		                                                       int32_t *humidity) {
+	return sht4x_measure_milli(me, SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD,
+			temperature, humidity);
+}
+
+#if CONFIG_SHT4X_MEDIUM_PRECISION
+/**
+ * @brief Function for a single shot measurement with medium repeatability.
+ *
+ * @param me   : Pointer to a sht4x_t instance
+ * @param temp : Temperature in thousandths of a degree centigrade.
+ * @param hum  : Humidity in thousandths of a percent relative humidity.
+ *
+ * @return 0 on success, an error code otherwise
+ */
+static inline esp_err_t sht4x_measure_medium_precision_milli(sht4x_t *const me,
+		                                                         int32_t *temperature,
+		                                                         int32_t *humidity) {
+	return sht4x_measure_milli(me, SHT4X_MEASURE_MEDIUM_PRECISION_TICKS_CMD,
+			temperature, humidity);
+}
+#endif /* CONFIG_SHT4X_MEDIUM_PRECISION */
+
+#if CONFIG_SHT4X_LOWEST_PRECISION
+/**
+ * @brief Function for a single shot measurement with lowest repeatability.
+ *
+ * @param me   : Pointer to a sht4x_t instance
+ * @param temp : Temperature in thousandths of a degree centigrade.
+ * @param hum  : Humidity in thousandths of a percent relative humidity.
+ *
+ * @return 0 on success, an error code otherwise
+ */
+static inline esp_err_t sht4x_measure_lowest_precision_milli(sht4x_t *const me,
+		                                                         int32_t *temperature,
+		                                                         int32_t *humidity) {
+	return sht4x_measure_milli(me, SHT4X_MEASURE_LOWEST_PRECISION_TICKS_CMD,
+			temperature, humidity);
+}
+#endif /* CONFIG_SHT4X_LOWEST_PRECISION */
+#endif /* CONFIG_SHT4X_MILLI_API */
 
 /**
  * @brief Function for a single shot measurement with high repeatability.
@@ -221,10 +807,14 @@ esp_err_t sht4x_activate_lowest_heater_power_short(sht4x_t *const me,
  *
  * @return error_code 0 on success, an error code otherwise.
  */
-esp_err_t sht4x_measure_high_precision_ticks(sht4x_t *const me,
-		                                         uint16_t *temp_ticks,
-																						 uint16_t *hum_ticks);
+static inline esp_err_t sht4x_measure_high_precision_ticks(sht4x_t *const me,
+		                                                       uint16_t *temp_ticks,
+		                                                       uint16_t *hum_ticks) {
+	return sht4x_execute(me, SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD,
+			temp_ticks, hum_ticks);
+}
 
+#if CONFIG_SHT4X_MEDIUM_PRECISION
 /**
  * @brief Function for a single shot measurement with medium repeatability.
  *
@@ -236,10 +826,15 @@ esp_err_t sht4x_measure_high_precision_ticks(sht4x_t *const me,
  *
  * @return error_code 0 on success, an error code otherwise.
  */
-esp_err_t sht4x_measure_medium_precision_ticks(sht4x_t *const me,
-		                                           uint16_t *temp_ticks,
-																							 uint16_t *hum_ticks);
+static inline esp_err_t sht4x_measure_medium_precision_ticks(sht4x_t *const me,
+		                                                         uint16_t *temp_ticks,
+		                                                         uint16_t *hum_ticks) {
+	return sht4x_execute(me, SHT4X_MEASURE_MEDIUM_PRECISION_TICKS_CMD,
+			temp_ticks, hum_ticks);
+}
+#endif /* CONFIG_SHT4X_MEDIUM_PRECISION */
 
+#if CONFIG_SHT4X_LOWEST_PRECISION
 /**
  * @brief Function for a single shot measurement with lowest repeatability.
  *
@@ -251,10 +846,15 @@ esp_err_t sht4x_measure_medium_precision_ticks(sht4x_t *const me,
  *
  * @return error_code 0 on success, an error code otherwise.
  */
-esp_err_t sht4x_measure_lowest_precision_ticks(sht4x_t *const me,
-		                                           uint16_t *temp_ticks,
-																							 uint16_t *hum_ticks);
+static inline esp_err_t sht4x_measure_lowest_precision_ticks(sht4x_t *const me,
+		                                                         uint16_t *temp_ticks,
+		                                                         uint16_t *hum_ticks) {
+	return sht4x_execute(me, SHT4X_MEASURE_LOWEST_PRECISION_TICKS_CMD,
+			temp_ticks, hum_ticks);
+}
+#endif /* CONFIG_SHT4X_LOWEST_PRECISION */
 
+#if CONFIG_SHT4X_HEATER
 /**
  * @brief Function to activate highest heater power and perform a single shot high
  * precision measurement for 1s.
@@ -267,9 +867,12 @@ esp_err_t sht4x_measure_lowest_precision_ticks(sht4x_t *const me,
  *
  * @return error_code 0 on success, an error code otherwise.
  */
-esp_err_t sht4x_activate_highest_heater_power_long_ticks(sht4x_t *const me,
-		                                                     uint16_t *temp_ticks,
-																												 uint16_t *hum_ticks);
+static inline esp_err_t sht4x_activate_highest_heater_power_long_ticks(sht4x_t *const me,
+		                                                                   uint16_t *temp_ticks,
+		                                                                   uint16_t *hum_ticks) {
+	return sht4x_execute(me, SHT4X_ACTIVATE_HIGHEST_HEATER_POWER_LONG_TICKS_CMD,
+			temp_ticks, hum_ticks);
+}
 
 /**
  * @brief Function to activate highest heater power and perform a single
@@ -283,9 +886,12 @@ esp_err_t sht4x_activate_highest_heater_power_long_ticks(sht4x_t *const me,
  *
  * @return error_code 0 on success, an error code otherwise.
  */
-esp_err_t sht4x_activate_highest_heater_power_short_ticks(sht4x_t *const me,
-		                                                      uint16_t *temp_ticks,
-																													uint16_t *hum_ticks);
+static inline esp_err_t sht4x_activate_highest_heater_power_short_ticks(sht4x_t *const me,
+		                                                                    uint16_t *temp_ticks,
+		                                                                    uint16_t *hum_ticks) {
+	return sht4x_execute(me, SHT4X_ACTIVATE_HIGHEST_HEATER_POWER_SHORT_TICKS_CMD,
+			temp_ticks, hum_ticks);
+}
 
 /**
  * @brief Function to activate medium heater power and perform a single
@@ -300,9 +906,12 @@ esp_err_t sht4x_activate_highest_heater_power_short_ticks(sht4x_t *const me,
  * @return error_code 0 on success, an error code otherwise.
  */
 
-esp_err_t sht4x_activate_medium_heater_power_long_ticks(sht4x_t *const me,
-		                                                    uint16_t *temp_ticks,
-																												uint16_t *hum_ticks);
+static inline esp_err_t sht4x_activate_medium_heater_power_long_ticks(sht4x_t *const me,
+		                                                                  uint16_t *temp_ticks,
+		                                                                  uint16_t *hum_ticks) {
+	return sht4x_execute(me, SHT4X_ACTIVATE_MEDIUM_HEATER_POWER_LONG_TICKS_CMD,
+			temp_ticks, hum_ticks);
+}
 
 /**
  * @brief Function to activate medium heater power and perform a single
@@ -316,9 +925,12 @@ esp_err_t sht4x_activate_medium_heater_power_long_ticks(sht4x_t *const me,
  *
  * @return error_code 0 on success, an error code otherwise.
  */
-esp_err_t sht4x_activate_medium_heater_power_short_ticks(sht4x_t *const me,
-		                                                     uint16_t *temp_ticks,
-																												 uint16_t *hum_ticks);
+static inline esp_err_t sht4x_activate_medium_heater_power_short_ticks(sht4x_t *const me,
+		                                                                   uint16_t *temp_ticks,
+		                                                                   uint16_t *hum_ticks) {
+	return sht4x_execute(me, SHT4X_ACTIVATE_MEDIUM_HEATER_POWER_SHORT_TICKS_CMD,
+			temp_ticks, hum_ticks);
+}
 
 /**
  * @brief Function to activate lowest heater power and perform a single
@@ -332,9 +944,12 @@ esp_err_t sht4x_activate_medium_heater_power_short_ticks(sht4x_t *const me,
  *
  * @return error_code 0 on success, an error code otherwise.
  */
-esp_err_t sht4x_activate_lowest_heater_power_long_ticks(sht4x_t *const me,
-		                                                    uint16_t *temp_ticks,
-																												uint16_t *hum_ticks);
+static inline esp_err_t sht4x_activate_lowest_heater_power_long_ticks(sht4x_t *const me,
+		                                                                  uint16_t *temp_ticks,
+		                                                                  uint16_t *hum_ticks) {
+	return sht4x_execute(me, SHT4X_ACTIVATE_LOWEST_HEATER_POWER_LONG_TICKS_CMD,
+			temp_ticks, hum_ticks);
+}
 
 /**
  * @brief Function to activate lowest heater power and perform a single
@@ -348,9 +963,13 @@ esp_err_t sht4x_activate_lowest_heater_power_long_ticks(sht4x_t *const me,
  *
  * @return error_code 0 on success, an error code otherwise.
  */
-esp_err_t sht4x_activate_lowest_heater_power_short_ticks(sht4x_t *const me,
-		                                                     uint16_t *temp_ticks,
-																												 uint16_t *hum_ticks);
+static inline esp_err_t sht4x_activate_lowest_heater_power_short_ticks(sht4x_t *const me,
+		                                                                   uint16_t *temp_ticks,
+		                                                                   uint16_t *hum_ticks) {
+	return sht4x_execute(me, SHT4X_ACTIVATE_LOWEST_HEATER_POWER_SHORT_TICKS_CMD,
+			temp_ticks, hum_ticks);
+}
+#endif /* CONFIG_SHT4X_HEATER */
 
 /**
  * @brief Read out the serial number
@@ -360,7 +979,8 @@ esp_err_t sht4x_activate_lowest_heater_power_short_ticks(sht4x_t *const me,
  *
  * @note Each sensor has a unique serial number that is assigned by Sensirion
  * during production.It is stored in the one-time-programmable memory and cannot
- * be manipulated after production.
+ * be manipulated after production. The serial number is cached after the
+ * first successful read, later calls do not access the bus.
  *
  * @return error_code 0 on success, an error code otherwise.
  */
@@ -380,6 +1000,151 @@ esp_err_t sht4x_get_serial_number(sht4x_t *const me, uint32_t *serial_number);
  */
 esp_err_t sht4x_soft_reset(sht4x_t *const me);
 
+/**
+ * @brief Function to discard the state the driver keeps about a sensor that
+ * was reset by other means, e.g. an I2C general call. Drops the pending
+ * command, the heater timestamps, the cached serial number and the cached
+ * result, and makes the next command wait for the reset to complete.
+ *
+ * @param me : Pointer to a sht4x_t instance
+ */
+void sht4x_discard_state(sht4x_t *const me);
+
+#if CONFIG_SHT4X_I2C_MASTER
+/**
+ * @brief Function to switch the I2C device to asynchronous mode. The I2C bus
+ * must have been created with a non-zero trans_queue_depth. While enabled
+ * only sht4x_async_measure() can be used with this instance, the blocking and
+ * split-phase functions return ESP_ERR_INVALID_STATE.
+ *
+ * @param me : Pointer to a sht4x_t instance
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+esp_err_t sht4x_async_enable(sht4x_t *const me);
+
+/**
+ * @brief Function to switch the I2C device back to synchronous mode
+ *
+ * @param me : Pointer to a sht4x_t instance
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if a measurement is in
+ * flight, an error code otherwise
+ */
+esp_err_t sht4x_async_disable(sht4x_t *const me);
+
+/**
+ * @brief Function to perform a measurement without blocking any task. The
+ * command write is queued, the conversion wait is armed on an esp_timer from
+ * the write completion, and the read is queued when the timer expires.
+ *
+ * @param me     : Pointer to a sht4x_t instance
+ * @param cmd    : Command byte, one of the SHT4X_*_CMD macros
+ * @param cb     : Callback that receives the result. It may be called from
+ *                 the I2C ISR, so it must be short and must not block
+ * @param cb_arg : Argument passed to cb
+ *
+ * @return ESP_OK if the measurement was queued, ESP_ERR_INVALID_STATE if
+ * asynchronous mode is disabled or a measurement is already in flight, an
+ * error code otherwise
+ */
+esp_err_t sht4x_async_measure(sht4x_t *const me, uint8_t cmd,
+		                          sht4x_async_cb_t cb, void *cb_arg);
+#endif /* CONFIG_SHT4X_I2C_MASTER */
+
+#if CONFIG_SHT4X_RESULT_CACHE
+/**
+ * @brief Function to get the last measurement result if it is fresh enough.
+ * A result of a higher precision command than cmd is also accepted, heater
+ * results are never reused.
+ *
+ * @param me        : Pointer to a sht4x_t instance
+ * @param cmd       : Measurement command byte, one of the SHT4X_MEASURE_*_CMD
+ *                    macros
+ * @param max_age_us: Maximum age in us of the result
+ * @param record    : Pointer to store the cached result
+ *
+ * @return True if a result was stored in record, False otherwise
+ */
+bool sht4x_get_cached(sht4x_t *const me, uint8_t cmd, uint32_t max_age_us,
+		                  sht4x_record_t *record);
+
+/**
+ * @brief Function to get a measurement result no older than max_age_us. The
+ * cached result is returned if it is fresh enough, otherwise a conversion is
+ * started. Callers arriving while a conversion is in flight wait for it and
+ * share its result.
+ *
+ * @param me        : Pointer to a sht4x_t instance
+ * @param cmd       : Measurement command byte, one of the SHT4X_MEASURE_*_CMD
+ *                    macros
+ * @param max_age_us: Maximum age in us of the result
+ * @param record    : Pointer to store the result
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if cmd is not a measurement
+ * command, an error code of the conversion otherwise
+ */
+esp_err_t sht4x_measure_cached(sht4x_t *const me, uint8_t cmd,
+		                           uint32_t max_age_us, sht4x_record_t *record);
+
+/**
+ * @brief Function to discard the cached measurement result
+ *
+ * @param me : Pointer to a sht4x_t instance
+ */
+void sht4x_invalidate_cache(sht4x_t *const me);
+#endif /* CONFIG_SHT4X_RESULT_CACHE */
+
+#if CONFIG_SHT4X_STATS
+/**
+ * @brief Function to get a consistent snapshot of the instance statistics
+ *
+ * @param me    : Pointer to a sht4x_t instance
+ * @param stats : Pointer to store the statistics
+ */
+void sht4x_get_stats(sht4x_t *const me, sht4x_stats_t *stats);
+
+/**
+ * @brief Function to clear the instance statistics
+ *
+ * @param me : Pointer to a sht4x_t instance
+ */
+void sht4x_reset_stats(sht4x_t *const me);
+#endif /* CONFIG_SHT4X_STATS */
+
+/**
+ * @brief Function that generates the CRC-8 (polynomial 0x31, init 0xFF) used
+ * by the sensor.
+ *
+ * @param data : Pointer to the data
+ * @param len  : Length of the data
+ *
+ * @return CRC byte
+ */
+uint8_t sht4x_crc8(const uint8_t *data, size_t len);
+
+/**
+ * @brief Function that checks both CRCs of a raw response
+ *
+ * @param frame : Raw response
+ *
+ * @return True if both CRCs match, False otherwise
+ */
+bool sht4x_check_frame(const sht4x_frame_t *frame);
+
+/**
+ * @brief Function that checks the CRCs of an array of raw responses
+ *
+ * @param frames     : Array of raw responses
+ * @param frames_num : Number of raw responses
+ * @param valid      : Array where the result of each frame is stored. Can be
+ *                     NULL
+ *
+ * @return Number of frames with valid CRCs
+ */
+size_t sht4x_check_frames(const sht4x_frame_t *frames, size_t frames_num,
+		                      bool *valid);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,319 @@
+/**
+  ******************************************************************************
+  * @file           : sht4x_convert.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : SHT4x tick conversion helpers
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SHT4X_CONVERT_H_
+#define SHT4X_CONVERT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sht4x.h"
+
+/* Exported Macros -----------------------------------------------------------*/
+#define SHT4X_TICKS_MAX	65535
+
+/* Constant conversions, e.g. for thresholds known at compile time */
+#define SHT4X_CELSIUS_TO_TICKS(t)			((uint16_t)(((t) + 45) * SHT4X_TICKS_MAX / 175))
+#define SHT4X_PERCENT_RH_TO_TICKS(rh)	((uint16_t)(((rh) + 6) * SHT4X_TICKS_MAX / 125))
+#define SHT4X_CELSIUS_DELTA_TO_TICKS(dt)			((uint16_t)((dt) * SHT4X_TICKS_MAX / 175))
+#define SHT4X_PERCENT_RH_DELTA_TO_TICKS(drh)	((uint16_t)((drh) * SHT4X_TICKS_MAX / 125))
+
+/* Bits of sht4x_derived_t valid */
+#define SHT4X_DERIVED_SATURATION				(1 << 0)
+#define SHT4X_DERIVED_DEW_POINT					(1 << 1)
+#define SHT4X_DERIVED_ABSOLUTE_HUMIDITY	(1 << 2)
+#define SHT4X_DERIVED_VPD								(1 << 3)
+
+/* Exported typedef ----------------------------------------------------------*/
+#if CONFIG_SHT4X_FLOAT_API
+typedef struct {
+	uint16_t temp_ticks;			/*!< Temperature ticks of the reading */
+	uint16_t hum_ticks;				/*!< Humidity ticks of the reading */
+	uint8_t valid;						/*!< SHT4X_DERIVED_* bits of the values computed */
+	float magnus;							/*!< Magnus term a * T / (b + T) */
+	float saturation_hpa;			/*!< Saturation vapour pressure in hPa */
+	float dew_point;					/*!< Dew point in degrees centigrade */
+	float absolute_humidity;	/*!< Absolute humidity in g/m3 */
+	float vpd;								/*!< Vapour pressure deficit in kPa */
+} sht4x_derived_t;
+#endif /* CONFIG_SHT4X_FLOAT_API */
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Inline functions ----------------------------------------------------------*/
+#if CONFIG_SHT4X_FLOAT_API
+/**
+ * @brief Function to convert temperature ticks to degrees centigrade
+ *
+ * @param ticks : Temperature ticks
+ *
+ * @return Temperature in degrees centigrade
+ */
+static inline float sht4x_convert_ticks_to_celsius(uint16_t ticks) {
+	return (float)ticks * (175.0f / SHT4X_TICKS_MAX) - 45.0f;
+}
+
+/**
+ * @brief Function to convert temperature ticks to degrees Fahrenheit
+ *
+ * @param ticks : Temperature ticks
+ *
+ * @return Temperature in degrees Fahrenheit
+ */
+static inline float sht4x_convert_ticks_to_fahrenheit(uint16_t ticks) {
+	return (float)ticks * (315.0f / SHT4X_TICKS_MAX) - 49.0f;
+}
+
+/**
+ * @brief Function to convert humidity ticks to percent relative humidity
+ *
+ * @param ticks : Humidity ticks
+ *
+ * @return Humidity in percent relative humidity
+ */
+static inline float sht4x_convert_ticks_to_percent_rh(uint16_t ticks) {
+	return (float)ticks * (125.0f / SHT4X_TICKS_MAX) - 6.0f;
+}
+#endif /* CONFIG_SHT4X_FLOAT_API */
+
+/**
+ * @brief Function to convert temperature ticks to hundredths of a degree
+ * centigrade, rounded to nearest
+ *
+ * @param ticks : Temperature ticks
+ *
+ * @return Temperature in 0.01 degrees centigrade
+ */
+static inline int16_t sht4x_convert_ticks_to_centi_celsius(uint16_t ticks) {
+	return (int16_t)(((uint32_t)ticks * 17500 + SHT4X_TICKS_MAX / 2) /
+			SHT4X_TICKS_MAX) - 4500;
+}
+
+/**
+ * @brief Function to convert humidity ticks to hundredths of a percent
+ * relative humidity, rounded to nearest
+ *
+ * @param ticks : Humidity ticks
+ *
+ * @return Humidity in 0.01 percent relative humidity
+ */
+static inline int16_t sht4x_convert_ticks_to_centi_percent_rh(uint16_t ticks) {
+	return (int16_t)(((uint32_t)ticks * 12500 + SHT4X_TICKS_MAX / 2) /
+			SHT4X_TICKS_MAX) - 600;
+}
+
+/**
+ * @brief Function to convert temperature ticks to thousandths of a degree
+ * centigrade, rounded to nearest. Exact 32-bit integer math: 175000 / 65535
+ * is split as 2 + 43930 / 65535 so no intermediate overflows.
+ *
+ * @param ticks : Temperature ticks
+ *
+ * @return Temperature in 0.001 degrees centigrade
+ */
+static inline int32_t sht4x_convert_ticks_to_milli_celsius(uint16_t ticks) {
+	return (int32_t)(2 * (uint32_t)ticks + ((uint32_t)ticks * 43930 +
+			SHT4X_TICKS_MAX / 2) / SHT4X_TICKS_MAX) - 45000;
+}
+
+/**
+ * @brief Function to convert humidity ticks to thousandths of a percent
+ * relative humidity, rounded to nearest. Exact 32-bit integer math: 125000 /
+ * 65535 is split as 1 + 59465 / 65535 so no intermediate overflows.
+ *
+ * @param ticks : Humidity ticks
+ *
+ * @return Humidity in 0.001 percent relative humidity
+ */
+static inline int32_t sht4x_convert_ticks_to_milli_percent_rh(uint16_t ticks) {
+	return (int32_t)((uint32_t)ticks + ((uint32_t)ticks * 59465 +
+			SHT4X_TICKS_MAX / 2) / SHT4X_TICKS_MAX) - 6000;
+}
+
+/* Exported functions prototypes ---------------------------------------------*/
+#if CONFIG_SHT4X_FLOAT_API
+/**
+ * @brief Function to convert an array of temperature ticks to degrees
+ * centigrade
+ *
+ * @param ticks : Array of temperature ticks
+ * @param out   : Array of temperatures, can not overlap ticks
+ * @param len   : Number of elements
+ */
+void sht4x_convert_celsius_bulk(const uint16_t *ticks, float *out, size_t len);
+
+/**
+ * @brief Function to convert an array of temperature ticks to degrees
+ * Fahrenheit
+ *
+ * @param ticks : Array of temperature ticks
+ * @param out   : Array of temperatures, can not overlap ticks
+ * @param len   : Number of elements
+ */
+void sht4x_convert_fahrenheit_bulk(const uint16_t *ticks, float *out,
+		                               size_t len);
+
+/**
+ * @brief Function to convert an array of humidity ticks to percent relative
+ * humidity
+ *
+ * @param ticks : Array of humidity ticks
+ * @param out   : Array of humidities, can not overlap ticks
+ * @param len   : Number of elements
+ */
+void sht4x_convert_percent_rh_bulk(const uint16_t *ticks, float *out,
+		                               size_t len);
+
+/**
+ * @brief Function to convert an array of records to degrees centigrade and
+ * percent relative humidity. Records with an error status are converted too,
+ * check the status before using the values.
+ *
+ * @param records     : Array of records
+ * @param records_num : Number of records
+ * @param temp        : Array of temperatures. Can be NULL
+ * @param hum         : Array of humidities. Can be NULL
+ */
+void sht4x_convert_records(const sht4x_record_t *records, size_t records_num,
+		                       float *temp, float *hum);
+
+/**
+ * @brief Function to set the reading the derived quantities are computed
+ * from. The cached values are kept if the reading did not change, otherwise
+ * they are computed again on the next request.
+ *
+ * @param me         : Pointer to a sht4x_derived_t instance, zero-initialized
+ *                     before the first update
+ * @param temp_ticks : Temperature ticks
+ * @param hum_ticks  : Humidity ticks
+ */
+void sht4x_derived_update(sht4x_derived_t *const me, uint16_t temp_ticks,
+		                      uint16_t hum_ticks);
+
+/**
+ * @brief Function to get the dew point of the reading
+ *
+ * @param me : Pointer to a sht4x_derived_t instance
+ *
+ * @note Magnus formula with fast log and exp approximations, within 0.01
+ * degrees centigrade of the exact formula
+ *
+ * @return Dew point in degrees centigrade
+ */
+float sht4x_derived_get_dew_point(sht4x_derived_t *const me);
+
+/**
+ * @brief Function to get the absolute humidity of the reading
+ *
+ * @param me : Pointer to a sht4x_derived_t instance
+ *
+ * @return Absolute humidity in g/m3
+ */
+float sht4x_derived_get_absolute_humidity(sht4x_derived_t *const me);
+
+/**
+ * @brief Function to get the vapour pressure deficit of the reading
+ *
+ * @param me : Pointer to a sht4x_derived_t instance
+ *
+ * @return Vapour pressure deficit in kPa
+ */
+float sht4x_derived_get_vpd(sht4x_derived_t *const me);
+
+/**
+ * @brief Function to compute the derived quantities of arrays of ticks
+ *
+ * @param temp_ticks        : Array of temperature ticks
+ * @param hum_ticks         : Array of humidity ticks
+ * @param len               : Number of elements
+ * @param dew_point         : Array of dew points in degrees centigrade. Can be
+ *                            NULL
+ * @param absolute_humidity : Array of absolute humidities in g/m3. Can be NULL
+ * @param vpd               : Array of vapour pressure deficits in kPa. Can be
+ *                            NULL
+ */
+void sht4x_convert_derived_bulk(const uint16_t *temp_ticks,
+		                            const uint16_t *hum_ticks, size_t len,
+																float *dew_point, float *absolute_humidity,
+																float *vpd);
+#endif /* CONFIG_SHT4X_FLOAT_API */
+
+/**
+ * @brief Function to convert an array of temperature ticks to hundredths of a
+ * degree centigrade
+ *
+ * @param ticks : Array of temperature ticks
+ * @param out   : Array of temperatures, can be the same array as ticks
+ * @param len   : Number of elements
+ */
+void sht4x_convert_centi_celsius_bulk(const uint16_t *ticks, int16_t *out,
+		                                  size_t len);
+
+/**
+ * @brief Function to convert an array of humidity ticks to hundredths of a
+ * percent relative humidity
+ *
+ * @param ticks : Array of humidity ticks
+ * @param out   : Array of humidities, can be the same array as ticks
+ * @param len   : Number of elements
+ */
+void sht4x_convert_centi_percent_rh_bulk(const uint16_t *ticks, int16_t *out,
+		                                     size_t len);
+
+/**
+ * @brief Function to convert an array of records to thousandths of a degree
+ * centigrade and thousandths of a percent relative humidity
+ *
+ * @param records     : Array of records
+ * @param records_num : Number of records
+ * @param temp        : Array of temperatures. Can be NULL
+ * @param hum         : Array of humidities. Can be NULL
+ */
+void sht4x_convert_records_milli(const sht4x_record_t *records,
+		                             size_t records_num, int32_t *temp,
+																 int32_t *hum);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHT4X_CONVERT_H_ */
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,113 @@
+/**
+  ******************************************************************************
+  * @file           : sht4x_filter.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : SHT4x streaming tick filters
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SHT4X_FILTER_H_
+#define SHT4X_FILTER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+
+#if CONFIG_SHT4X_FILTER
+/* Exported Macros -----------------------------------------------------------*/
+#define SHT4X_FILTER_WINDOW_MAX	CONFIG_SHT4X_FILTER_WINDOW
+
+/* Exported typedef ----------------------------------------------------------*/
+typedef enum {
+	SHT4X_FILTER_NONE = 0,	/*!< Output the input */
+	SHT4X_FILTER_BOX,				/*!< Moving average of the last window samples */
+	SHT4X_FILTER_EMA,				/*!< Exponential moving average, alpha = 1 / 2^shift */
+	SHT4X_FILTER_MEDIAN			/*!< Median of the last window samples */
+} sht4x_filter_type_t;
+
+typedef struct {
+	sht4x_filter_type_t type;												/*!< Filter type */
+	uint8_t param;																	/*!< Window length or EMA shift */
+	uint8_t count;																	/*!< Samples in the window */
+	uint8_t index;																	/*!< Next window slot */
+	uint32_t acc;																		/*!< Window sum or EMA state with 16 fractional bits */
+	uint16_t window[SHT4X_FILTER_WINDOW_MAX];				/*!< Last samples */
+} sht4x_filter_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+ * @brief Function to initialize a tick filter
+ *
+ * @param me    : Pointer to a sht4x_filter_t instance
+ * @param type  : Filter type
+ * @param param : Window length, 1 to SHT4X_FILTER_WINDOW_MAX, for
+ *                SHT4X_FILTER_BOX and SHT4X_FILTER_MEDIAN, shift, 1 to 15,
+ *                for SHT4X_FILTER_EMA. Ignored for SHT4X_FILTER_NONE
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if param is out of range
+ */
+esp_err_t sht4x_filter_init(sht4x_filter_t *const me, sht4x_filter_type_t type,
+		                        uint8_t param);
+
+/**
+ * @brief Function to discard the history of a tick filter
+ *
+ * @param me : Pointer to a sht4x_filter_t instance
+ */
+void sht4x_filter_reset(sht4x_filter_t *const me);
+
+/**
+ * @brief Function to feed a sample to a tick filter. Until the window is full
+ * the output is computed over the samples received so far.
+ *
+ * @param me    : Pointer to a sht4x_filter_t instance
+ * @param ticks : New sample
+ *
+ * @return Filtered ticks
+ */
+uint16_t sht4x_filter_update(sht4x_filter_t *const me, uint16_t ticks);
+#endif /* CONFIG_SHT4X_FILTER */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHT4X_FILTER_H_ */
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,211 @@
+/**
+  ******************************************************************************
+  * @file           : sht4x_history.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : SHT4x compressed reading history
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SHT4X_HISTORY_H_
+#define SHT4X_HISTORY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_partition.h"
+
+#include "sht4x.h"
+
+#if CONFIG_SHT4X_HISTORY
+/* Exported Macros -----------------------------------------------------------*/
+#define SHT4X_HISTORY_HEADER_LEN	24
+#define SHT4X_HISTORY_DATA_LEN		(CONFIG_SHT4X_HISTORY_BLOCK_SIZE - SHT4X_HISTORY_HEADER_LEN)
+
+#define SHT4X_HISTORY_CONFIG_DEFAULT() {	\
+		.blocks_num = 16,										\
+		.time_tolerance_ms = 20,						\
+		.partition_label = NULL							\
+}
+
+/* Exported typedef ----------------------------------------------------------*/
+typedef struct {
+	size_t blocks_num;						/*!< Blocks kept in RAM */
+	uint32_t time_tolerance_ms;		/*!< Timestamp error accepted to keep the sampling period implicit */
+	const char *partition_label;	/*!< Data partition full blocks spill to, NULL to keep RAM only */
+} sht4x_history_config_t;
+
+/* Block of readings, independently decodable. The first reading is stored
+ * as a keyframe in the header, every following one as zig-zag varint deltas:
+ * (delta temp << 1 | meta), delta hum and, when meta is set, the new
+ * sampling period in ms and the flags. */
+typedef struct {
+	int64_t timestamp_us;		/*!< Timestamp of the keyframe */
+	uint32_t seq;						/*!< Sequence number of the block */
+	uint16_t temp_ticks;		/*!< Temperature ticks of the keyframe */
+	uint16_t hum_ticks;			/*!< Humidity ticks of the keyframe */
+	uint16_t samples;				/*!< Readings in the block, keyframe included */
+	uint16_t len;						/*!< Bytes of data used */
+	uint8_t flags;					/*!< SHT4X_RECORD_FLAG_* bits of the keyframe */
+	uint8_t reserved[3];		/*!< Padding of the header */
+	uint8_t data[SHT4X_HISTORY_DATA_LEN];	/*!< Encoded deltas */
+} sht4x_history_block_t;
+
+typedef struct {
+	uint16_t sample;				/*!< Readings decoded from the block, 0 before the keyframe */
+	uint16_t offset;				/*!< Offset of the next delta in the block data */
+	int64_t timestamp_us;		/*!< Timestamp of the last reading */
+	uint32_t period_ms;			/*!< Sampling period in ms */
+	uint16_t temp_ticks;		/*!< Temperature ticks of the last reading */
+	uint16_t hum_ticks;			/*!< Humidity ticks of the last reading */
+	uint8_t flags;					/*!< SHT4X_RECORD_FLAG_* bits of the last reading */
+} sht4x_history_cursor_t;
+
+typedef struct {
+	sht4x_history_config_t config;		/*!< History configuration */
+	sht4x_history_block_t *blocks;		/*!< RAM blocks, block seq is stored at seq % blocks_num */
+	size_t ram_count;									/*!< Blocks in RAM, the newest one is open */
+	uint32_t newest_seq;							/*!< Sequence number of the open block */
+	sht4x_history_cursor_t writer;		/*!< Encoder state of the open block */
+	sht4x_history_cursor_t reader;		/*!< Decoder state of the oldest block */
+	const esp_partition_t *partition;	/*!< Spill partition, NULL if none */
+	size_t flash_slots;								/*!< Blocks that fit in the partition */
+	size_t flash_head;								/*!< Slot of the next block spilled */
+	size_t flash_count;								/*!< Blocks in the partition, older than the RAM blocks */
+	sht4x_history_block_t scratch;		/*!< Block read back from the partition */
+	uint32_t dropped;									/*!< Blocks overwritten before they were read */
+	SemaphoreHandle_t mutex;					/*!< Serializes writer and reader */
+} sht4x_history_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+ * @brief Function to initialize a history store
+ *
+ * @param me     : Pointer to a sht4x_history_t instance
+ * @param config : History configuration
+ *
+ * @note Blocks left in the partition by a previous boot are not recovered,
+ * the partition is reused from its start
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the partition does not
+ * exist, ESP_ERR_INVALID_SIZE if CONFIG_SHT4X_HISTORY_BLOCK_SIZE does not
+ * divide its erase size, an error code otherwise
+ */
+esp_err_t sht4x_history_init(sht4x_history_t *const me,
+		                         const sht4x_history_config_t *config);
+
+/**
+ * @brief Function to free the resources of a history store
+ *
+ * @param me : Pointer to a sht4x_history_t instance
+ */
+void sht4x_history_deinit(sht4x_history_t *const me);
+
+/**
+ * @brief Function to append a reading. A new block is started when the open
+ * one is full; when every RAM block is in use the oldest one spills to the
+ * partition or, without partition, is overwritten.
+ *
+ * @param me     : Pointer to a sht4x_history_t instance
+ * @param record : Reading to append
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the record has an error
+ * status, an error code otherwise
+ */
+esp_err_t sht4x_history_append(sht4x_history_t *const me,
+		                           const sht4x_record_t *record);
+
+/**
+ * @brief Function to read and remove the oldest readings, decoded. Reading
+ * can be resumed at any point, also in the middle of a block.
+ *
+ * @param me          : Pointer to a sht4x_history_t instance
+ * @param records     : Array where the readings are stored, oldest first
+ * @param records_num : Capacity of records
+ *
+ * @return Number of readings stored
+ */
+size_t sht4x_history_read(sht4x_history_t *const me, sht4x_record_t *records,
+		                      size_t records_num);
+
+/**
+ * @brief Function to remove the oldest block without decoding it, e.g. to
+ * upload it compressed. Readings of the block already returned by
+ * sht4x_history_read() are returned again by sht4x_history_decode_block().
+ *
+ * @param me    : Pointer to a sht4x_history_t instance
+ * @param block : Pointer to store the block
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the history is empty, an
+ * error code otherwise
+ */
+esp_err_t sht4x_history_pop_block(sht4x_history_t *const me,
+		                              sht4x_history_block_t *block);
+
+/**
+ * @brief Function to decode every reading of a block
+ *
+ * @param block       : Pointer to a block
+ * @param records     : Array where the readings are stored, oldest first
+ * @param records_num : Capacity of records
+ *
+ * @return Number of readings stored, less than block->samples if records is
+ * too small or the block is corrupted
+ */
+size_t sht4x_history_decode_block(const sht4x_history_block_t *block,
+		                              sht4x_record_t *records, size_t records_num);
+
+/**
+ * @brief Function to get the amount of blocks overwritten before they were
+ * read
+ *
+ * @param me : Pointer to a sht4x_history_t instance
+ *
+ * @return Number of dropped blocks
+ */
+uint32_t sht4x_history_get_dropped(sht4x_history_t *const me);
+#endif /* CONFIG_SHT4X_HISTORY */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHT4X_HISTORY_H_ */
+
+/***************************** END OF FILE ************************************/
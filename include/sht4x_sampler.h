@@ -0,0 +1,278 @@
+/**
+  ******************************************************************************
+  * @file           : sht4x_sampler.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : Background periodic sampling for SHT4x sensors
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SHT4X_SAMPLER_H_
+#define SHT4X_SAMPLER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_event.h"
+
+#include "sht4x.h"
+#include "sht4x_convert.h"
+#include "sht4x_history.h"
+
+/* Exported Macros -----------------------------------------------------------*/
+#define SHT4X_SAMPLER_CONFIG_DEFAULT() {									\
+		.period_ms = 1000,																		\
+		.cmd = SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD,				\
+		.buffer_len = 64,																			\
+		.core_id = tskNO_AFFINITY,														\
+		.priority = 5,																				\
+		.stack_size = 3072,																		\
+		.post_events = false,																	\
+		.event_loop = NULL,																		\
+		.heater_cmd = 0,																			\
+		.heater_rh_ticks = SHT4X_PERCENT_RH_TO_TICKS(95),			\
+		.heater_hold_ms = 60000,															\
+		.adaptive = false,																		\
+		.idle_period_ms = 10000,															\
+		.deadband_temp_ticks = SHT4X_CELSIUS_DELTA_TO_TICKS(0.2),	\
+		.deadband_hum_ticks = SHT4X_PERCENT_RH_DELTA_TO_TICKS(1),	\
+		.settle_samples = 10,																	\
+		.report_on_change = false,														\
+		.report_temp_ticks = SHT4X_CELSIUS_DELTA_TO_TICKS(0.1),	\
+		.report_hum_ticks = SHT4X_PERCENT_RH_DELTA_TO_TICKS(0.5),	\
+		.heartbeat_ms = 600000																\
+}
+
+/* Exported typedef ----------------------------------------------------------*/
+typedef enum {
+	SHT4X_EVENT_READING = 0,	/*!< New reading, data is sht4x_event_data_t */
+	SHT4X_EVENT_ERROR					/*!< Failed measurement, data is sht4x_event_data_t */
+} sht4x_event_id_t;
+
+typedef struct {
+	sht4x_t *dev;						/*!< Instance that produced the record */
+	sht4x_record_t record;	/*!< Timestamped ticks and status */
+} sht4x_event_data_t;
+
+typedef struct {
+	uint32_t period_ms;			/*!< Sampling period in ms */
+	uint8_t cmd;						/*!< Measurement command */
+	size_t buffer_len;			/*!< Ring buffer capacity, rounded up to a power of two */
+	BaseType_t core_id;			/*!< Core of the sampling task or tskNO_AFFINITY */
+	UBaseType_t priority;		/*!< Priority of the sampling task */
+	uint32_t stack_size;		/*!< Stack size of the sampling task in bytes */
+	bool post_events;				/*!< Post SHT4X_EVENT events for every record */
+	esp_event_loop_handle_t event_loop;	/*!< Loop to post to. If NULL a dedicated loop is created */
+	uint8_t heater_cmd;							/*!< Heater command of the creep compensation pulses, 0 to disable */
+	uint16_t heater_rh_ticks;				/*!< Humidity ticks at or above which a pulse is scheduled */
+	uint32_t heater_hold_ms;				/*!< Time humidity has to stay high before a pulse */
+	bool adaptive;									/*!< Drop to lowest precision and idle_period_ms while readings are flat */
+	uint32_t idle_period_ms;				/*!< Sampling period in ms while idle */
+	uint16_t deadband_temp_ticks;		/*!< Temperature change in ticks that counts as flat */
+	uint16_t deadband_hum_ticks;		/*!< Humidity change in ticks that counts as flat */
+	uint32_t settle_samples;				/*!< Consecutive flat samples before going idle */
+	bool report_on_change;					/*!< Only deliver readings that moved or are due by heartbeat_ms */
+	uint16_t report_temp_ticks;			/*!< Temperature change in ticks that is delivered */
+	uint16_t report_hum_ticks;			/*!< Humidity change in ticks that is delivered */
+	uint32_t heartbeat_ms;					/*!< Maximum time in ms between deliveries, 0 for none */
+#if CONFIG_SHT4X_HISTORY
+	sht4x_history_t *history;				/*!< History the delivered readings are appended to. Can be NULL */
+#endif
+} sht4x_sampler_config_t;
+
+typedef struct {
+	sht4x_t *dev;										/*!< Sampled instance */
+	sht4x_sampler_config_t config;	/*!< Sampler configuration */
+	TaskHandle_t task;							/*!< Sampling task handle */
+	SemaphoreHandle_t stop_sem;			/*!< Given by the task when it exits */
+	volatile bool running;					/*!< Cleared to stop the task */
+	sht4x_record_t *buffer;					/*!< Ring buffer storage */
+	size_t mask;										/*!< Ring buffer capacity - 1 */
+	size_t head;										/*!< Write index, only written by the task */
+	size_t tail;										/*!< Read index, only written by the consumer */
+	uint32_t dropped;								/*!< Records dropped because the buffer was full */
+	esp_event_loop_handle_t event_loop;	/*!< Loop the events are posted to */
+	bool event_loop_owned;					/*!< True if event_loop was created by the sampler */
+	volatile uint8_t heater_request;	/*!< Heater command requested by sht4x_sampler_heat(), 0 if none */
+	int64_t rh_high_since_us;				/*!< Time humidity went high, 0 while it is not */
+	bool idle;											/*!< True while adaptive sampling is idle */
+	uint32_t flat_samples;					/*!< Consecutive samples within the dead-band */
+	sht4x_record_t anchor;					/*!< Reading the dead-band is centred on, status != ESP_OK if none */
+	sht4x_record_t reported;				/*!< Last delivered reading, status != ESP_OK if none */
+	uint32_t suppressed;						/*!< Readings not delivered by report_on_change */
+	sht4x_record_t latest[2];				/*!< Double buffer of the last successful reading */
+	volatile uint32_t latest_seq;		/*!< Readings published, latest[latest_seq & 1] is the newest */
+} sht4x_sampler_t;
+
+/* Exported variables --------------------------------------------------------*/
+ESP_EVENT_DECLARE_BASE(SHT4X_EVENT);
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+ * @brief Function to start a background sampling task
+ *
+ * @param me     : Pointer to a sht4x_sampler_t instance
+ * @param dev    : Pointer to an initialized sht4x_t instance
+ * @param config : Sampler configuration
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+esp_err_t sht4x_sampler_start(sht4x_sampler_t *const me, sht4x_t *dev,
+		                          const sht4x_sampler_config_t *config);
+
+/**
+ * @brief Function to stop the sampling task and free its resources
+ *
+ * @param me : Pointer to a sht4x_sampler_t instance
+ */
+void sht4x_sampler_stop(sht4x_sampler_t *const me);
+
+/**
+ * @brief Function to request a heater pulse from the sampling task without
+ * blocking. The pulse replaces the next measurement and its record is flagged
+ * with SHT4X_RECORD_FLAG_HEATER, the records of the following
+ * CONFIG_SHT4X_HEATER_RECOVERY_MS with SHT4X_RECORD_FLAG_HEATER_RECOVERY. The
+ * pulse is postponed while the heater duty-cycle budget is exhausted.
+ *
+ * @param me  : Pointer to a sht4x_sampler_t instance
+ * @param cmd : Heater command, one of the SHT4X_ACTIVATE_*_CMD macros
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if cmd is not a heater
+ * command
+ */
+esp_err_t sht4x_sampler_heat(sht4x_sampler_t *const me, uint8_t cmd);
+
+/**
+ * @brief Function to get the event loop the sampler posts to, e.g. to
+ * register handlers on the dedicated loop
+ *
+ * @param me : Pointer to a sht4x_sampler_t instance
+ *
+ * @return Event loop handle or NULL if events are disabled
+ */
+esp_event_loop_handle_t sht4x_sampler_get_event_loop(sht4x_sampler_t *const me);
+
+/**
+ * @brief Function to get the amount of records waiting in the ring buffer
+ *
+ * @param me : Pointer to a sht4x_sampler_t instance
+ *
+ * @return Number of records
+ */
+size_t sht4x_sampler_available(sht4x_sampler_t *const me);
+
+/**
+ * @brief Function to drain records from the ring buffer. Lock-free, must be
+ * called by a single consumer task.
+ *
+ * @param me          : Pointer to a sht4x_sampler_t instance
+ * @param records     : Array where the records are copied, oldest first
+ * @param records_num : Capacity of records
+ *
+ * @return Number of records copied
+ */
+size_t sht4x_sampler_read(sht4x_sampler_t *const me, sht4x_record_t *records,
+		                      size_t records_num);
+
+/**
+ * @brief Function to get the contiguous block of the oldest records without
+ * copying them. Must be called by the same single consumer task as
+ * sht4x_sampler_read().
+ *
+ * @param me      : Pointer to a sht4x_sampler_t instance
+ * @param records : Pointer to the oldest record in the ring buffer
+ *
+ * @return Number of contiguous records, release them with
+ * sht4x_sampler_release() once consumed
+ */
+size_t sht4x_sampler_peek(sht4x_sampler_t *const me,
+		                      const sht4x_record_t **records);
+
+/**
+ * @brief Function to release records obtained with sht4x_sampler_peek()
+ *
+ * @param me          : Pointer to a sht4x_sampler_t instance
+ * @param records_num : Number of records to release
+ */
+void sht4x_sampler_release(sht4x_sampler_t *const me, size_t records_num);
+
+/**
+ * @brief Function to get the amount of records dropped because the ring
+ * buffer was full
+ *
+ * @param me : Pointer to a sht4x_sampler_t instance
+ *
+ * @return Number of dropped records
+ */
+uint32_t sht4x_sampler_get_dropped(sht4x_sampler_t *const me);
+
+/**
+ * @brief Function to get the amount of readings not delivered because they
+ * did not change enough with report_on_change enabled
+ *
+ * @param me : Pointer to a sht4x_sampler_t instance
+ *
+ * @return Number of suppressed readings
+ */
+uint32_t sht4x_sampler_get_suppressed(sht4x_sampler_t *const me);
+
+/**
+ * @brief Function to get the last successful reading of the sampler without
+ * locking or blocking. Placed in IRAM and safe to call from an ISR, also
+ * while the flash cache is disabled if the sht4x_sampler_t instance is in
+ * internal RAM.
+ *
+ * @param me     : Pointer to a sht4x_sampler_t instance
+ * @param record : Pointer to store the reading
+ *
+ * @note Every successful reading is published, also the ones suppressed by
+ * report_on_change
+ *
+ * @return True on success or False if there is no reading yet or it was
+ * being replaced on another core during every retry
+ */
+bool sht4x_sampler_get_latest(const sht4x_sampler_t *me,
+		                          sht4x_record_t *record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHT4X_SAMPLER_H_ */
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,180 @@
+/**
+  ******************************************************************************
+  * @file           : sht4x_scheduler.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : Multi-sensor SHT4x conversion scheduler
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SHT4X_SCHEDULER_H_
+#define SHT4X_SCHEDULER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include "sht4x.h"
+
+/* Exported Macros -----------------------------------------------------------*/
+
+/* Exported typedef ----------------------------------------------------------*/
+typedef void (*sht4x_scheduler_cb_t)(const sht4x_record_t *records,
+		                                 size_t records_num, void *arg);
+
+typedef struct {
+	size_t dev_index;				/*!< Index of the device in the scheduler devices array */
+	sht4x_record_t record;	/*!< Result of the device */
+} sht4x_scheduler_item_t;
+
+typedef struct {
+	sht4x_t **devs;						/*!< Array of initialized instances */
+	size_t devs_num;					/*!< Number of instances in devs */
+	uint8_t cmd;							/*!< Command started on every instance */
+	sht4x_scheduler_cb_t cb;	/*!< Batch callback. Can be NULL */
+	void *cb_arg;							/*!< Argument passed to cb */
+	QueueHandle_t queue;			/*!< Queue of sht4x_scheduler_item_t. Can be NULL */
+} sht4x_scheduler_config_t;
+
+typedef struct {
+	uint32_t serial_number;	/*!< Serial number of the device */
+	sht4x_t *dev;						/*!< Instance of the device */
+	esp_err_t status;				/*!< Result of the serial number read */
+} sht4x_identity_t;
+
+typedef struct {
+	sht4x_scheduler_config_t config;	/*!< Scheduler configuration */
+	sht4x_record_t *records;					/*!< Results of the last sweep */
+} sht4x_scheduler_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+ * @brief Function to initialize a scheduler instance
+ *
+ * @param me     : Pointer to a sht4x_scheduler_t instance
+ * @param config : Scheduler configuration. The devices array must outlive the
+ *                 scheduler
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+esp_err_t sht4x_scheduler_init(sht4x_scheduler_t *const me,
+		                           const sht4x_scheduler_config_t *config);
+
+/**
+ * @brief Function to deinitialize a scheduler instance
+ *
+ * @param me : Pointer to a sht4x_scheduler_t instance
+ */
+void sht4x_scheduler_deinit(sht4x_scheduler_t *const me);
+
+/**
+ * @brief Function to perform one sweep over all the devices. The command is
+ * started on every device back-to-back, the calling task waits once for the
+ * longest conversion using the wait mode of the first device and then every
+ * result is read. The results are delivered to the callback and the queue.
+ *
+ * @param me      : Pointer to a sht4x_scheduler_t instance
+ * @param records : Pointer to the results, one per device in the same order
+ *                  as the devices array. Valid until the next sweep. Can be
+ *                  NULL
+ *
+ * @note All the devices must be reachable at the same time, devices behind
+ * different I2C mux channels need a scheduler per channel.
+ *
+ * @return ESP_OK if every device succeeded, ESP_FAIL otherwise. The status of
+ * each device is in its record
+ */
+esp_err_t sht4x_scheduler_sweep(sht4x_scheduler_t *const me,
+		                            const sht4x_record_t **records);
+
+#if CONFIG_SHT4X_I2C_MASTER
+/**
+ * @brief Function to reset every device with a single I2C general call
+ * (SHT4X_GENERAL_CALL_RESET sent to SHT4X_GENERAL_CALL_ADDR) per bus and wait
+ * once for the reset time
+ *
+ * @param me : Pointer to a sht4x_scheduler_t instance
+ *
+ * @note Every device on the buses is reset, including devices that are not
+ * SHT4x sensors but answer the general call. No command may be in flight
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if a device uses a custom
+ * transport, an error code otherwise
+ */
+esp_err_t sht4x_scheduler_reset(sht4x_scheduler_t *const me);
+#endif /* CONFIG_SHT4X_I2C_MASTER */
+
+/**
+ * @brief Function to read the serial number of every device. The command is
+ * started on every device back-to-back and the calling task waits once.
+ *
+ * @param me         : Pointer to a sht4x_scheduler_t instance
+ * @param identities : Array of devs_num entries where the serial number of
+ *                     each device is stored, in the same order as the
+ *                     devices array
+ *
+ * @note The serial numbers read are cached in each instance
+ *
+ * @return ESP_OK if every device succeeded, ESP_FAIL otherwise. The status of
+ * each device is in its entry
+ */
+esp_err_t sht4x_scheduler_discover(sht4x_scheduler_t *const me,
+		                               sht4x_identity_t *identities);
+
+/**
+ * @brief Function to find a device by its cached serial number. The bus is
+ * not accessed
+ *
+ * @param me            : Pointer to a sht4x_scheduler_t instance
+ * @param serial_number : Serial number to look for
+ *
+ * @note Only devices whose serial number has been read, e.g. by
+ * sht4x_scheduler_discover() or sht4x_get_serial_number(), are found
+ *
+ * @return Pointer to the device, NULL if not found
+ */
+sht4x_t *sht4x_scheduler_find(const sht4x_scheduler_t *me,
+		                          uint32_t serial_number);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHT4X_SCHEDULER_H_ */
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,124 @@
+/**
+  ******************************************************************************
+  * @file           : sht4x_sim.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : Simulated SHT4x sensor transport
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SHT4X_SIM_H_
+#define SHT4X_SIM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sht4x.h"
+
+#if CONFIG_SHT4X_SIM
+/* Exported Macros -----------------------------------------------------------*/
+
+/* Exported typedef ----------------------------------------------------------*/
+typedef struct {
+	uint32_t nack_every;		/*!< NACK every Nth command write, 0 to disable */
+	uint32_t crc_every;			/*!< Corrupt a CRC of every Nth response, 0 to disable */
+	uint32_t timeout_every;	/*!< Time out every Nth transaction, 0 to disable */
+} sht4x_sim_faults_t;
+
+typedef struct {
+	uint16_t temp_ticks;				/*!< Temperature ticks returned by measurements */
+	uint16_t hum_ticks;					/*!< Humidity ticks returned by measurements */
+	uint32_t serial_number;			/*!< Serial number returned by SHT4X_SERIAL_NUMBER_CMD */
+	sht4x_sim_faults_t faults;	/*!< Injected faults */
+	uint8_t cmd;								/*!< Command being executed */
+	bool response;							/*!< True while a response is waiting to be read */
+	int64_t ready_time_us;			/*!< Time at which the command finishes */
+	uint32_t writes;						/*!< Command writes received */
+	uint32_t reads;							/*!< Responses sent */
+	uint32_t transactions;			/*!< Transactions received */
+} sht4x_sim_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+ * @brief Function to initialize a simulated sensor without faults
+ *
+ * @param me            : Pointer to a sht4x_sim_t instance
+ * @param temp_ticks    : Temperature ticks returned by measurements
+ * @param hum_ticks     : Humidity ticks returned by measurements
+ * @param serial_number : Serial number of the sensor
+ */
+void sht4x_sim_init(sht4x_sim_t *const me, uint16_t temp_ticks,
+		                uint16_t hum_ticks, uint32_t serial_number);
+
+/**
+ * @brief Function to change the ticks returned by the next measurements
+ *
+ * @param me         : Pointer to a sht4x_sim_t instance
+ * @param temp_ticks : Temperature ticks
+ * @param hum_ticks  : Humidity ticks
+ */
+void sht4x_sim_set_ticks(sht4x_sim_t *const me, uint16_t temp_ticks,
+		                     uint16_t hum_ticks);
+
+/**
+ * @brief Function to select the faults injected by the simulated sensor
+ *
+ * @param me     : Pointer to a sht4x_sim_t instance
+ * @param faults : Faults to inject
+ */
+void sht4x_sim_set_faults(sht4x_sim_t *const me,
+		                      const sht4x_sim_faults_t *faults);
+
+/**
+ * @brief Function to get the transport of a simulated sensor, to be passed to
+ * sht4x_init_with_transport(). Commands take their typical execution time
+ * and the sensor NACKs reads while it is busy, like the real one.
+ *
+ * @param me        : Pointer to a sht4x_sim_t instance
+ * @param transport : Pointer to store the transport
+ */
+void sht4x_sim_get_transport(sht4x_sim_t *const me,
+		                         sht4x_transport_t *transport);
+#endif /* CONFIG_SHT4X_SIM */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHT4X_SIM_H_ */
+
+/***************************** END OF FILE ************************************/
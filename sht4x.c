@@ -34,49 +34,213 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "sht4x.h"
+#include "sht4x_convert.h"
 
+#include <string.h>
+
+#include "esp_attr.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_sleep.h"
+#endif
+#include "freertos/task.h"
 
 /* Private macros ------------------------------------------------------------*/
+/* The asynchronous I2C callback checks the CRC with the cache disabled */
+#if CONFIG_I2C_ISR_IRAM_SAFE && !CONFIG_SHT4X_IRAM_SAFE
+#error "CONFIG_I2C_ISR_IRAM_SAFE requires CONFIG_SHT4X_IRAM_SAFE"
+#endif
+
 #define NOP() asm volatile ("nop")
 #define CRC8_POLYNOMIAL 0x31
 #define CRC8_INIT 0xFF
 #define CRC8_LEN 1
 
+/* Asynchronous measurement states */
+#define ASYNC_STATE_IDLE	0
+#define ASYNC_STATE_TX		1
+#define ASYNC_STATE_WAIT	2
+#define ASYNC_STATE_RX		3
+
+#if CONFIG_SHT4X_STATS
+#define STATS_ADD(me, field, value) do {					\
+		portENTER_CRITICAL(&(me)->stats_lock);				\
+		(me)->stats.field += (value);									\
+		portEXIT_CRITICAL(&(me)->stats_lock);					\
+} while (0)
+#else
+#define STATS_ADD(me, field, value)
+#endif
+
+#if CONFIG_SHT4X_PM_LOCK
+#define PM_ACQUIRE(me)	esp_pm_lock_acquire((me)->pm_lock)
+#define PM_RELEASE(me)	esp_pm_lock_release((me)->pm_lock)
+#else
+#define PM_ACQUIRE(me)
+#define PM_RELEASE(me)
+#endif
+
+#if CONFIG_SHT4X_THREAD_SAFE
+#define LOCK(me)		xSemaphoreTake((me)->lock, portMAX_DELAY)
+#define UNLOCK(me)	xSemaphoreGive((me)->lock)
+#define WAITERS_MAX	16
+#else
+#define LOCK(me)
+#define UNLOCK(me)
+#endif
+
 /* External variables --------------------------------------------------------*/
 
 /* Private typedef -----------------------------------------------------------*/
+typedef struct {
+	uint8_t cmd;					/*!< Command byte */
+	uint32_t duration_us;	/*!< Maximum execution time in us */
+	uint32_t typical_us;	/*!< Typical execution time in us */
+	uint8_t rx_len;				/*!< Response length in bytes */
+	bool heater;					/*!< True if the command turns the heater on */
+	uint8_t precision;		/*!< Repeatability rank, 0 for non measurement commands */
+} cmd_desc_t;
+
 static const char *TAG = "sht4x";
 
 /* Private variables ---------------------------------------------------------*/
+#if CONFIG_SHT4X_CRC_TABLE_FULL
+/* CRC-8 lookup table, polynomial 0x31 */
+static const uint8_t SHT4X_DRAM_ATTR crc8_table[256] = {
+		0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97,
+		0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E,
+		0x43, 0x72, 0x21, 0x10, 0x87, 0xB6, 0xE5, 0xD4,
+		0xFA, 0xCB, 0x98, 0xA9, 0x3E, 0x0F, 0x5C, 0x6D,
+		0x86, 0xB7, 0xE4, 0xD5, 0x42, 0x73, 0x20, 0x11,
+		0x3F, 0x0E, 0x5D, 0x6C, 0xFB, 0xCA, 0x99, 0xA8,
+		0xC5, 0xF4, 0xA7, 0x96, 0x01, 0x30, 0x63, 0x52,
+		0x7C, 0x4D, 0x1E, 0x2F, 0xB8, 0x89, 0xDA, 0xEB,
+		0x3D, 0x0C, 0x5F, 0x6E, 0xF9, 0xC8, 0x9B, 0xAA,
+		0x84, 0xB5, 0xE6, 0xD7, 0x40, 0x71, 0x22, 0x13,
+		0x7E, 0x4F, 0x1C, 0x2D, 0xBA, 0x8B, 0xD8, 0xE9,
+		0xC7, 0xF6, 0xA5, 0x94, 0x03, 0x32, 0x61, 0x50,
+		0xBB, 0x8A, 0xD9, 0xE8, 0x7F, 0x4E, 0x1D, 0x2C,
+		0x02, 0x33, 0x60, 0x51, 0xC6, 0xF7, 0xA4, 0x95,
+		0xF8, 0xC9, 0x9A, 0xAB, 0x3C, 0x0D, 0x5E, 0x6F,
+		0x41, 0x70, 0x23, 0x12, 0x85, 0xB4, 0xE7, 0xD6,
+		0x7A, 0x4B, 0x18, 0x29, 0xBE, 0x8F, 0xDC, 0xED,
+		0xC3, 0xF2, 0xA1, 0x90, 0x07, 0x36, 0x65, 0x54,
+		0x39, 0x08, 0x5B, 0x6A, 0xFD, 0xCC, 0x9F, 0xAE,
+		0x80, 0xB1, 0xE2, 0xD3, 0x44, 0x75, 0x26, 0x17,
+		0xFC, 0xCD, 0x9E, 0xAF, 0x38, 0x09, 0x5A, 0x6B,
+		0x45, 0x74, 0x27, 0x16, 0x81, 0xB0, 0xE3, 0xD2,
+		0xBF, 0x8E, 0xDD, 0xEC, 0x7B, 0x4A, 0x19, 0x28,
+		0x06, 0x37, 0x64, 0x55, 0xC2, 0xF3, 0xA0, 0x91,
+		0x47, 0x76, 0x25, 0x14, 0x83, 0xB2, 0xE1, 0xD0,
+		0xFE, 0xCF, 0x9C, 0xAD, 0x3A, 0x0B, 0x58, 0x69,
+		0x04, 0x35, 0x66, 0x57, 0xC0, 0xF1, 0xA2, 0x93,
+		0xBD, 0x8C, 0xDF, 0xEE, 0x79, 0x48, 0x1B, 0x2A,
+		0xC1, 0xF0, 0xA3, 0x92, 0x05, 0x34, 0x67, 0x56,
+		0x78, 0x49, 0x1A, 0x2B, 0xBC, 0x8D, 0xDE, 0xEF,
+		0x82, 0xB3, 0xE0, 0xD1, 0x46, 0x77, 0x24, 0x15,
+		0x3B, 0x0A, 0x59, 0x68, 0xFF, 0xCE, 0x9D, 0xAC
+};
+#elif CONFIG_SHT4X_CRC_TABLE_NIBBLE
+/* CRC-8 lookup table for 4-bit chunks, polynomial 0x31 */
+static const uint8_t SHT4X_DRAM_ATTR crc8_table[16] = {
+		0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97,
+		0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E
+};
+#endif
+
+/* Commands with their maximum and typical execution times from the datasheet,
+ * only the ones selected in Kconfig. Looked up at run time by get_cmd_desc(),
+ * so disabling commands shortens the search but does not make their timings
+ * compile-time constants */
+static const cmd_desc_t cmd_descs[] = {
+		{SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD,              8300,    6900,    6, false, 3},
+#if CONFIG_SHT4X_MEDIUM_PRECISION
+		{SHT4X_MEASURE_MEDIUM_PRECISION_TICKS_CMD,            4500,    3700,    6, false, 2},
+#endif
+#if CONFIG_SHT4X_LOWEST_PRECISION
+		{SHT4X_MEASURE_LOWEST_PRECISION_TICKS_CMD,            1700,    1300,    6, false, 1},
+#endif
+#if CONFIG_SHT4X_HEATER
+		{SHT4X_ACTIVATE_HIGHEST_HEATER_POWER_LONG_TICKS_CMD,  1100000, 1000000, 6, true,  0},
+		{SHT4X_ACTIVATE_HIGHEST_HEATER_POWER_SHORT_TICKS_CMD, 110000,  100000,  6, true,  0},
+		{SHT4X_ACTIVATE_MEDIUM_HEATER_POWER_LONG_TICKS_CMD,   1100000, 1000000, 6, true,  0},
+		{SHT4X_ACTIVATE_MEDIUM_HEATER_POWER_SHORT_TICKS_CMD,  110000,  100000,  6, true,  0},
+		{SHT4X_ACTIVATE_LOWEST_HEATER_POWER_LONG_TICKS_CMD,   1100000, 1000000, 6, true,  0},
+		{SHT4X_ACTIVATE_LOWEST_HEATER_POWER_SHORT_TICKS_CMD,  110000,  100000,  6, true,  0},
+#endif
+		{SHT4X_SERIAL_NUMBER_CMD,                             10000,   1000,    6, false, 0},
+		{SHT4X_SOFT_RESET_CMD,                                1000,    1000,    0, false, 0}
+};
 
 /* Private function prototypes -----------------------------------------------*/
+#if CONFIG_SHT4X_I2C_MASTER
 /**
  * @brief Function that implements the default I2C read transaction
  *
  * @param reg_addr : Register address to be read
  * @param reg_data : Pointer to the data to be read from reg_addr
  * @param data_len : Length of the data transfer
- * @param intf     : Pointer to the interface descriptor
+ * @param intf     : Pointer to a sht4x_t instance
  *
- * @return 0 if successful, non-zero otherwise
+ * @return ESP_OK on success, SHT4X_ERR_NACK or SHT4X_ERR_TIMEOUT on failure
  */
-static int8_t i2c_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t data_len,
-		                   void *intf);
+static esp_err_t i2c_read(uint8_t reg_addr, uint8_t *reg_data,
+		                      uint32_t data_len, void *intf);
 /**
  * @brief Function that implements the default I2C write transaction
  *
  * @param reg_addr : Register address to be written
  * @param reg_data : Pointer to the data to be written to reg_addr
  * @param data_len : Length of the data transfer
- * @param intf     : Pointer to the interface descriptor
+ * @param intf     : Pointer to a sht4x_t instance
+ *
+ * @return ESP_OK on success, SHT4X_ERR_NACK or SHT4X_ERR_TIMEOUT on failure
+ */
+static esp_err_t i2c_write(uint8_t reg_addr, const uint8_t *reg_data,
+		                       uint32_t data_len, void *intf);
+#endif /* CONFIG_SHT4X_I2C_MASTER */
+
+/**
+ * @brief Function that sets the defaults and creates the resources shared by
+ * every transport
+ *
+ * @param me : Pointer to a sht4x_t instance with its transport set
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+static esp_err_t init_instance(sht4x_t *const me);
+
+/**
+ * @brief Function that deletes the resources created by init_instance() and
+ * sht4x_set_wait_mode(), in reverse order. Handles that are NULL are skipped
+ *
+ * @param me : Pointer to a sht4x_t instance
+ */
+static void free_instance(sht4x_t *const me);
+
+#if CONFIG_SHT4X_I2C_MASTER
+/**
+ * @brief Function that adds the device to its bus again with another SCL
+ * frequency
+ *
+ * @param me           : Pointer to a sht4x_t instance
+ * @param scl_speed_hz : SCL frequency
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+static esp_err_t set_speed(sht4x_t *const me, uint32_t scl_speed_hz);
+
+/**
+ * @brief Function that maps an I2C master driver error to a driver error
  *
- * @return 0 if successful, non-zero otherwise
+ * @param err : Error returned by the I2C master driver
+ *
+ * @return SHT4X_ERR_NACK, SHT4X_ERR_TIMEOUT or err unchanged
  */
-static int8_t i2c_write(uint8_t reg_addr, const uint8_t *reg_data,
-		                    uint32_t data_len, void *intf);
+static esp_err_t classify_i2c_err(esp_err_t err);
+#endif /* CONFIG_SHT4X_I2C_MASTER */
 /**
  * @brief Function that implements a micro seconds delay
  *
@@ -85,67 +249,248 @@ static int8_t i2c_write(uint8_t reg_addr, const uint8_t *reg_data,
 static void delay_us(uint32_t period_us);
 
 /**
- * @brief Function to convert temperature ticks to physical temperature
+ * @brief Function that waits for the sensor using the instance wait mode
+ *
+ * @param me        : Pointer to a sht4x_t instance
+ * @param period_us : Time in us to wait
+ */
+static void wait_us(sht4x_t *const me, uint32_t period_us);
+
+/**
+ * @brief Callback of the wait timer, wakes up the task blocked in wait_us()
+ *
+ * @param arg : Pointer to a sht4x_t instance
+ */
+static void wait_timer_cb(void *arg);
+
+#if CONFIG_SHT4X_I2C_MASTER
+/**
+ * @brief Callback of the I2C master driver for the asynchronous measurement,
+ * called from ISR context
+ *
+ * @param i2c_dev  : I2C device handle
+ * @param evt_data : Result of the transaction
+ * @param arg      : Pointer to a sht4x_t instance
+ *
+ * @return True if a higher priority task was woken up
+ */
+static bool async_trans_done_cb(i2c_master_dev_handle_t i2c_dev,
+		                            const i2c_master_event_data_t *evt_data,
+																void *arg);
+
+/**
+ * @brief Callback of the asynchronous conversion timer, queues the read
+ *
+ * @param arg : Pointer to a sht4x_t instance
+ */
+static void async_timer_cb(void *arg);
+
+/**
+ * @brief Function that ends the asynchronous measurement and delivers the
+ * result
+ *
+ * @param me     : Pointer to a sht4x_t instance
+ * @param status : Result of the measurement
+ */
+static void async_finish(sht4x_t *const me, esp_err_t status);
+
+/**
+ * @brief Function that atomically moves the asynchronous state machine out of
+ * the idle state, so only one caller can start a transaction
+ *
+ * @param me : Pointer to a sht4x_t instance
+ *
+ * @return True if the instance was idle and is now owned by the caller
+ */
+static bool async_take(sht4x_t *const me);
+#endif /* CONFIG_SHT4X_I2C_MASTER */
+
+/**
+ * @brief Function that checks the heater duty-cycle budget
+ *
+ * @param me   : Pointer to a sht4x_t instance
+ * @param desc : Descriptor of the command about to be sent
+ *
+ * @return ESP_OK if the command may be sent, ESP_ERR_INVALID_STATE otherwise
+ */
+static esp_err_t heater_check(const sht4x_t *me, const cmd_desc_t *desc);
+
+/**
+ * @brief Function that accounts a heater pulse started now in the duty-cycle
+ * budget. Only called once the command has been sent.
+ *
+ * @param me   : Pointer to a sht4x_t instance
+ * @param desc : Descriptor of the command sent
+ */
+static void heater_commit(sht4x_t *const me, const cmd_desc_t *desc);
+
+/**
+ * @brief Function that reads the response of the pending command and gives
+ * up the ownership of the bus
+ *
+ * @param me    : Pointer to a sht4x_t instance
+ * @param poll  : True to read before the maximum execution time
+ * @param frame : Pointer to store the response
+ * @param cmd   : Pointer to store the command that produced the response,
+ *                captured while the instance is locked
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+static esp_err_t read_frame(sht4x_t *const me, bool poll, sht4x_frame_t *frame,
+		                        uint8_t *cmd);
+
+/**
+ * @brief Function that clears the pending command, the heater timestamps and
+ * the cached serial number, as after a reset of the sensor
+ *
+ * @param me : Pointer to a sht4x_t instance
+ */
+static void clear_state(sht4x_t *const me);
+
+/**
+ * @brief Function that gets the SHT4X_RECORD_FLAG_* bits of a result read now
+ *
+ * @param me  : Pointer to a sht4x_t instance
+ * @param cmd : Command that produced the result
+ *
+ * @return SHT4X_RECORD_FLAG_* bits
+ */
+static uint8_t result_flags(const sht4x_t *me, uint8_t cmd);
+
+/**
+ * @brief Function that looks up the descriptor of a command
  *
- * @param ticks temperature in ticks
+ * @param cmd : Command byte
  *
- * @return Temperature in degrees centigrade.
+ * @return Pointer to the descriptor or NULL for unknown commands
  */
-static float convert_ticks_to_celsius(uint16_t ticks);
+static const cmd_desc_t *get_cmd_desc(uint8_t cmd);
 
 /**
- * @brief Convert humidity ticks to physical humidity
+ * @brief Function that makes the calling task the owner of the next command,
+ * waiting for a command of another task to end. Must be called with the lock
+ * held
  *
- * @param ticks relative humidity in ticks
+ * @param me : Pointer to a sht4x_t instance
+ */
+static void claim(sht4x_t *const me);
+
+/**
+ * @brief Function that ends the command in flight and wakes up the tasks
+ * waiting for it. Must be called with the lock held
  *
- * @return Humidity in percent relative humidity.
+ * @param me     : Pointer to a sht4x_t instance
+ * @param status : Result of the command
+ * @param frame  : Response of the command, NULL if there is none
  */
-static float convert_ticks_to_percent_rh(uint16_t ticks);
+static void release(sht4x_t *const me, esp_err_t status,
+		                const sht4x_frame_t *frame);
 
+#if CONFIG_SHT4X_THREAD_SAFE
 /**
- * @brief Function that generates a CRC byte for a given data
+ * @brief Function that waits, with the lock released, until the command in
+ * flight ends. An owner that does not end its command within the I2C timeout
+ * after its ready time loses it. Must be called with the lock held
  *
- * @param data  :
- * @param count :
+ * @param me : Pointer to a sht4x_t instance
+ */
+static void wait_release(sht4x_t *const me);
+#endif
+
+/**
+ * @brief Function that accounts an I2C transaction in the statistics
  *
- * @return CRC byte
+ * @param me       : Pointer to a sht4x_t instance
+ * @param start_us : Time the transaction started
+ * @param err      : Result of the transaction, ESP_ERR_NOT_FINISHED for an
+ *                   early read NACKed by a busy sensor
  */
-static uint8_t generate_crc(const uint8_t *data, uint16_t count);
+static void stats_bus(sht4x_t *const me, int64_t start_us, esp_err_t err);
 
 /**
- * @brief Function that checks the CRC for the received data
+ * @brief Function that accounts the latency of a successful sht4x_execute()
  *
- * @param data     :
- * @param count    :
- * @param checksum :
+ * @param me       : Pointer to a sht4x_t instance
+ * @param start_us : Time the command started
+ */
+static void stats_latency(sht4x_t *const me, int64_t start_us);
+
+#if CONFIG_SHT4X_RESULT_CACHE
+/**
+ * @brief Function that stores a measurement result in the instance cache
  *
- * @return False on failure or True on success
+ * @param me         : Pointer to a sht4x_t instance
+ * @param cmd        : Command that produced the result
+ * @param temp_ticks : Temperature ticks
+ * @param hum_ticks  : Humidity ticks
  */
-static bool check_crc(const uint8_t *data, uint16_t count, uint8_t checksum);
+static void cache_store(sht4x_t *const me, uint8_t cmd, uint16_t temp_ticks,
+		                    uint16_t hum_ticks);
+#endif
 
 /* Exported functions definitions --------------------------------------------*/
+#if CONFIG_SHT4X_I2C_MASTER
 /**
  * @brief Function to initialize a SHT4x instance
  */
 esp_err_t sht4x_init(sht4x_t *const me, i2c_master_bus_handle_t i2c_bus_handle,
 		uint8_t dev_addr) {
+	const sht4x_config_t config = SHT4X_CONFIG_DEFAULT(dev_addr);
+
+	return sht4x_init_with_config(me, i2c_bus_handle, &config);
+}
+
+/**
+ * @brief Function to initialize a SHT4x instance with a custom bus
+ * configuration
+ */
+esp_err_t sht4x_init_with_config(sht4x_t *const me,
+		                             i2c_master_bus_handle_t i2c_bus_handle,
+		                             const sht4x_config_t *config) {
 	/* Print initializing message */
 	ESP_LOGI(TAG, "Initializing instance...");
 
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
+	if (config == NULL || config->scl_speed_hz == 0) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
 	/* Add device to I2C bus */
 	i2c_device_config_t i2c_dev_conf = {
-			.scl_speed_hz = 400000,
-			.device_address = dev_addr
+			.dev_addr_length = I2C_ADDR_BIT_LEN_7,
+			.device_address = config->dev_addr,
+			.scl_speed_hz = config->scl_speed_hz,
+			.scl_wait_us = config->scl_wait_us
 	};
 
-	if (i2c_master_bus_add_device(i2c_bus_handle, &i2c_dev_conf, &me->i2c_dev) != ESP_OK) {
+	ret = i2c_master_bus_add_device(i2c_bus_handle, &i2c_dev_conf, &me->i2c_dev);
+
+	if (ret != ESP_OK) {
 		ESP_LOGE(TAG, "Failed to add device to I2C bus");
 		return ret;
 	}
 
+	me->i2c_bus = i2c_bus_handle;
+	me->i2c_dev_conf = i2c_dev_conf;
+
+	/* Use the I2C master driver as transport */
+	me->transport.read = i2c_read;
+	me->transport.write = i2c_write;
+	me->transport.intf = me;
+
+	ret = init_instance(me);
+
+	if (ret != ESP_OK) {
+		i2c_master_bus_rm_device(me->i2c_dev);
+		me->i2c_dev = NULL;
+		return ret;
+	}
+
+	me->timeout_ms = config->timeout_ms;
+	me->poll_interval_us = config->poll_interval_us;
+
 	/* Print successful initialization message */
 	ESP_LOGI(TAG, "Instance initialized successfully");
 
@@ -154,653 +499,1328 @@ esp_err_t sht4x_init(sht4x_t *const me, i2c_master_bus_handle_t i2c_bus_handle,
 }
 
 /**
- * @brief Function for a single shot measurement with high repeatability.
+ * @brief Function to find the fastest SCL frequency at which the sensor
+ * answers reliably.
  */
-esp_err_t sht4x_measure_high_precision(sht4x_t *const me, float *temp,
-		                                   float *hum) {
+esp_err_t sht4x_probe_speed(sht4x_t *const me, const uint32_t *speeds_hz,
+		                        size_t speeds_num, uint32_t attempts,
+		                        uint32_t *speed_hz) {
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
-	/* Get temperature and humidity ticks */
-	uint16_t temp_ticks = 0;
-	uint16_t hum_ticks = 0;
+	if (speeds_hz == NULL || speeds_num == 0 || attempts == 0) {
+		return ESP_ERR_INVALID_ARG;
+	}
 
-	ret = sht4x_measure_high_precision_ticks(me, &temp_ticks, &hum_ticks);
+	if (me->i2c_dev == NULL) {
+		return ESP_ERR_NOT_SUPPORTED;
+	}
 
-	if (ret != ESP_OK) {
-		return ESP_FAIL;
+	if (me->async_enabled) {
+		return ESP_ERR_INVALID_STATE;
 	}
 
-	/* Calculate physical temperature and humidity values */
-	*temp = convert_ticks_to_celsius(temp_ticks);
-	*hum = convert_ticks_to_percent_rh(hum_ticks);
+	uint32_t original_hz = me->i2c_dev_conf.scl_speed_hz;
+	uint32_t limit_hz = UINT32_MAX;
+	uint32_t best_hz = 0;
 
-	/* Return ESP_OK */
-	return ret;
-}
+	while (best_hz == 0) {
+		/* Try the fastest candidate not tried yet */
+		uint32_t candidate_hz = 0;
 
-/**
- * @brief Function for a single shot measurement with medium repeatability.
- */
-esp_err_t sht4x_measure_medium_precision(sht4x_t *const me, float *temp,
-		                                     float *hum) {
-	/* Variable to return error code */
-	esp_err_t ret = ESP_OK;
+		for (size_t i = 0; i < speeds_num; i++) {
+			if (speeds_hz[i] > candidate_hz && speeds_hz[i] < limit_hz) {
+				candidate_hz = speeds_hz[i];
+			}
+		}
 
-	/* Get temperature and humidity ticks */
-	uint16_t temp_ticks = 0;
-	uint16_t hum_ticks = 0;
+		if (candidate_hz == 0) {
+			break;
+		}
 
-	ret = sht4x_measure_medium_precision_ticks(me, &temp_ticks, &hum_ticks);
+		limit_hz = candidate_hz;
 
-	if (ret != ESP_OK) {
-		return ESP_FAIL;
-	}
+		ret = set_speed(me, candidate_hz);
 
-	/* Calculate physical temperature and humidity values */
-	*temp = convert_ticks_to_celsius(temp_ticks);
-	*hum = convert_ticks_to_percent_rh(hum_ticks);
+		if (ret != ESP_OK) {
+			break;
+		}
 
+		uint32_t passed = 0;
+		uint16_t words[2] = {0};
 
-	/* Return ESP_OK */
-	return ret;
-}
+		/* Read the serial number from the bus, bypassing the cached copy */
+		while (passed < attempts && sht4x_execute(me, SHT4X_SERIAL_NUMBER_CMD,
+				&words[0], &words[1]) == ESP_OK) {
+			passed++;
+		}
 
-/**
- * @brief Function for a single shot measurement with lowest repeatability.
- */
-esp_err_t sht4x_measure_lowest_precision(sht4x_t *const me, float *temp,
-		                                     float *hum) {
-	/* Variable to return error code */
-	esp_err_t ret = ESP_OK;
+		ESP_LOGD(TAG, "%lu Hz: %lu/%lu reads", (unsigned long)candidate_hz,
+				(unsigned long)passed, (unsigned long)attempts);
 
-	/* Get temperature and humidity ticks */
-	uint16_t temp_ticks = 0;
-	uint16_t hum_ticks = 0;
+		if (passed == attempts) {
+			best_hz = candidate_hz;
+		}
+	}
 
-	ret = sht4x_measure_lowest_precision_ticks(me, &temp_ticks, &hum_ticks);
+	/* Keep the previous frequency if no candidate passed */
+	if (best_hz == 0) {
+		if (set_speed(me, original_hz) != ESP_OK) {
+			ESP_LOGE(TAG, "Failed to restore the I2C clock");
+		}
 
-	if (ret != ESP_OK) {
-		return ESP_FAIL;
+		return ret != ESP_OK ? ret : ESP_ERR_NOT_FOUND;
 	}
 
-	/* Calculate physical temperature and humidity values */
-	*temp = convert_ticks_to_celsius(temp_ticks);
-	*hum = convert_ticks_to_percent_rh(hum_ticks);
+	if (speed_hz != NULL) {
+		*speed_hz = best_hz;
+	}
 
 	/* Return ESP_OK */
-	return ret;
+	return ESP_OK;
 }
+#endif /* CONFIG_SHT4X_I2C_MASTER */
 
 /**
- * @brief Function to activate highest heater power and perform a single
- * shot high precision measurement for 1s.
+ * @brief Function to initialize a SHT4x instance on a custom transport
  */
-esp_err_t sht4x_activate_highest_heater_power_long(sht4x_t *const me,
-		                                               float *temp,
-																									 float *hum) {
+esp_err_t sht4x_init_with_transport(sht4x_t *const me,
+		                                const sht4x_transport_t *transport) {
+	/* Print initializing message */
+	ESP_LOGI(TAG, "Initializing instance...");
+
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
-	/* Get temperature and humidity ticks */
-	uint16_t temp_ticks = 0;
-	uint16_t hum_ticks = 0;
+	if (transport == NULL || transport->read == NULL ||
+			transport->write == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
 
-	ret = sht4x_activate_highest_heater_power_long_ticks(me, &temp_ticks, &hum_ticks);
+#if CONFIG_SHT4X_I2C_MASTER
+	me->i2c_bus = NULL;
+	me->i2c_dev = NULL;
+#endif
+	me->transport = *transport;
+
+	ret = init_instance(me);
 
 	if (ret != ESP_OK) {
-		return ESP_FAIL;
+		return ret;
 	}
 
-	/* Calculate physical temperature and humidity values */
-	*temp = convert_ticks_to_celsius(temp_ticks);
-	*hum = convert_ticks_to_percent_rh(hum_ticks);
+	/* Print successful initialization message */
+	ESP_LOGI(TAG, "Instance initialized successfully");
 
 	/* Return ESP_OK */
 	return ret;
 }
 
 /**
- * @brief Function to activate highest heater power and perform a single
- * shot high precision measurement for 0.1s.
+ * @brief Function to deinitialize a SHT4x instance
  */
-esp_err_t sht4x_activate_highest_heater_power_short(sht4x_t *const me,
-		                                                float *temp,
-																										float *hum) {
+esp_err_t sht4x_deinit(sht4x_t *const me) {
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
-	/* Get temperature and humidity ticks */
-	uint16_t temp_ticks = 0;
-	uint16_t hum_ticks = 0;
-
-	ret = sht4x_activate_highest_heater_power_short_ticks(me, &temp_ticks, &hum_ticks);
+#if CONFIG_SHT4X_I2C_MASTER
+	/* Leave asynchronous mode */
+	ret = sht4x_async_disable(me);
 
 	if (ret != ESP_OK) {
-		return ESP_FAIL;
+		return ret;
 	}
+#endif
 
-	/* Calculate physical temperature and humidity values */
-	*temp = convert_ticks_to_celsius(temp_ticks);
-	*hum = convert_ticks_to_percent_rh(hum_ticks);
-
-	/* Return ESP_OK */
-	return ret;
-}
-
-/**
- * @brief Function to activate medium heater power and perform a single
- * shot high precision measurement for 1s.
- */
-esp_err_t sht4x_activate_medium_heater_power_long(sht4x_t *const me,
-		                                              float *temp,
-																									float *hum) {
-	/* Variable to return error code */
-	esp_err_t ret = ESP_OK;
+	/* Release the instance resources */
+	free_instance(me);
 
-	/* Get temperature and humidity ticks */
-	uint16_t temp_ticks = 0;
-	uint16_t hum_ticks = 0;
+#if CONFIG_SHT4X_I2C_MASTER
+	/* Custom transports are owned by the application */
+	if (me->i2c_dev == NULL) {
+		return ret;
+	}
 
-	ret = sht4x_activate_medium_heater_power_long_ticks(me, &temp_ticks, &hum_ticks);
+	/* Remove device from I2C bus */
+	ret = i2c_master_bus_rm_device(me->i2c_dev);
 
 	if (ret != ESP_OK) {
-		return ESP_FAIL;
+		ESP_LOGE(TAG, "Failed to remove device from I2C bus");
+		return ret;
 	}
-
-	/* Calculate physical temperature and humidity values */
-	*temp = convert_ticks_to_celsius(temp_ticks);
-	*hum = convert_ticks_to_percent_rh(hum_ticks);
+#endif
 
 	/* Return ESP_OK */
 	return ret;
 }
 
 /**
- * @brief Function to activate medium heater power and perform a single
- * shot high precision measurement for 0.1s.
+ * @brief Function to select how the driver waits for the sensor to finish a
+ * command.
  */
-esp_err_t sht4x_activate_medium_heater_power_short(sht4x_t *const me,
-		                                               float *temp,
-																									 float *hum) {
+esp_err_t sht4x_set_wait_mode(sht4x_t *const me, sht4x_wait_mode_t wait_mode) {
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
-	/* Get temperature and humidity ticks */
-	uint16_t temp_ticks = 0;
-	uint16_t hum_ticks = 0;
+	/* Create the timer and semaphore the first time the delay or timer mode is
+	 * used, the delay mode waits the sub-tick remainder on the timer */
+	if ((wait_mode == SHT4X_WAIT_MODE_DELAY ||
+			wait_mode == SHT4X_WAIT_MODE_TIMER) && me->wait_timer == NULL) {
+		me->wait_sem = xSemaphoreCreateBinary();
+
+		if (me->wait_sem == NULL) {
+			ESP_LOGE(TAG, "Failed to create wait semaphore");
+			return ESP_ERR_NO_MEM;
+		}
 
-	ret = sht4x_activate_medium_heater_power_short_ticks(me, &temp_ticks, &hum_ticks);
+		const esp_timer_create_args_t timer_args = {
+				.callback = wait_timer_cb,
+				.arg = me,
+				.dispatch_method = ESP_TIMER_TASK,
+				.name = "sht4x_wait"
+		};
 
-	if (ret != ESP_OK) {
-		return ESP_FAIL;
+		ret = esp_timer_create(&timer_args, &me->wait_timer);
+
+		if (ret != ESP_OK) {
+			ESP_LOGE(TAG, "Failed to create wait timer");
+			vSemaphoreDelete(me->wait_sem);
+			me->wait_sem = NULL;
+			return ret;
+		}
 	}
 
-	/* Calculate physical temperature and humidity values */
-	*temp = convert_ticks_to_celsius(temp_ticks);
-	*hum = convert_ticks_to_percent_rh(hum_ticks);
+	me->wait_mode = wait_mode;
 
 	/* Return ESP_OK */
 	return ret;
 }
 
 /**
- * @brief Function to activate lowest heater power and perform a single
- * shot high precision measurement for 1s.
+ * @brief Function to set the timeout of every I2C transaction
  */
-esp_err_t sht4x_activate_lowest_heater_power_long(sht4x_t *const me,
-		                                              float *temp,
-																									float *hum) {
-	/* Variable to return error code */
-	esp_err_t ret = ESP_OK;
-
-	/* Get temperature and humidity ticks */
-	uint16_t temp_ticks = 0;
-	uint16_t hum_ticks = 0;
-
-	ret = sht4x_activate_lowest_heater_power_long_ticks(me, &temp_ticks, &hum_ticks);
-
-	if (ret != ESP_OK) {
-		return ESP_FAIL;
-	}
-
-	/* Calculate physical temperature and humidity values */
-	*temp = convert_ticks_to_celsius(temp_ticks);
-	*hum = convert_ticks_to_percent_rh(hum_ticks);
+void sht4x_set_timeout(sht4x_t *const me, int timeout_ms) {
+	me->timeout_ms = timeout_ms;
+}
 
-	/* Return ESP_OK */
-	return ret;
+/**
+ * @brief Function to enable or disable NACK polling in sht4x_execute()
+ */
+void sht4x_set_poll_interval(sht4x_t *const me, uint32_t interval_us) {
+	me->poll_interval_us = interval_us;
 }
 
 /**
- * @brief Function to activate lowest heater power and perform a single
- * shot high precision measurement for 0.1s.
+ * @brief Function to send a command without waiting for its result.
  */
-esp_err_t sht4x_activate_lowest_heater_power_short(sht4x_t *const me,
-		                                               float *temp,
-																									 float *hum) {
+esp_err_t sht4x_start_measurement(sht4x_t *const me, uint8_t cmd,
+		                              int64_t *ready_time_us) {
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
-	/* Get temperature and humidity ticks */
-	uint16_t temp_ticks = 0;
-	uint16_t hum_ticks = 0;
-
-	ret = sht4x_activate_lowest_heater_power_short_ticks(me, &temp_ticks, &hum_ticks);
+	const cmd_desc_t *desc = get_cmd_desc(cmd);
 
-	if (ret != ESP_OK) {
-		return ESP_FAIL;
+	if (desc == NULL) {
+		return ESP_ERR_INVALID_ARG;
 	}
 
-	/* Calculate physical temperature and humidity values */
-	*temp = convert_ticks_to_celsius(temp_ticks);
-	*hum = convert_ticks_to_percent_rh(hum_ticks);
+	LOCK(me);
+	claim(me);
 
-	/* Return ESP_OK */
-	return ret;
-}
+	/* Enforce the heater duty cycle */
+	ret = heater_check(me, desc);
 
-/**
- * @brief Function for a single shot measurement with high repeatability.
- */
-esp_err_t sht4x_measure_high_precision_ticks(sht4x_t *const me,
-		                                         uint16_t *temp_ticks,
-																						 uint16_t *hum_ticks) {
-	/* Variable to return error code */
-	esp_err_t ret = ESP_OK;
+	if (ret == ESP_OK) {
+		/* Send the command */
+		int64_t start_us = esp_timer_get_time();
 
-	/* Get temperature and humidity ticks */
-	if (i2c_write(SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD, NULL, 0, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+		PM_ACQUIRE(me);
+		ret = me->transport.write(cmd, NULL, 0, me->transport.intf);
+		PM_RELEASE(me);
+		stats_bus(me, start_us, ret);
+	}
+
+	if (ret != ESP_OK) {
+		release(me, ret, NULL);
+		UNLOCK(me);
+		return ret;
 	}
 
-	delay_us(10 * 1000); /* Wait for 10 ms */
+	/* Only a pulse that was actually started uses up the budget */
+	heater_commit(me, desc);
 
-	uint8_t data_rx[6] = {0};
-	if (i2c_read(0, data_rx, 6, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	/* Keep track of the pending result */
+	me->pending_cmd = cmd;
+	me->pending = desc->rx_len > 0;
+	me->ready_time_us = esp_timer_get_time() + sht4x_get_command_duration_us(cmd);
+
+	if (ready_time_us != NULL) {
+		*ready_time_us = me->ready_time_us;
 	}
 
-	/* Check data received CRC */
-	for (uint8_t i = 0; i < 6; i += 3) {
-		if (!check_crc(&data_rx[i], 2, data_rx[i + 2])) {
-			return ESP_FAIL;
-		}
+	/* Commands without response end with the write */
+	if (!me->pending) {
+		release(me, ret, NULL);
 	}
 
-	*temp_ticks = (uint16_t)((data_rx[0] << 8) | (data_rx[1]));
-	*hum_ticks = (uint16_t)((data_rx[3] << 8) | (data_rx[4]));
+	UNLOCK(me);
 
 	/* Return ESP_OK */
 	return ret;
 }
 
 /**
- * @brief Function for a single shot measurement with medium repeatability.
+ * @brief Function to read the raw response of the command sent by
+ * sht4x_start_measurement().
+ */
+esp_err_t sht4x_read_frame(sht4x_t *const me, bool poll, sht4x_frame_t *frame) {
+	uint8_t cmd = 0;
+
+	return read_frame(me, poll, frame, &cmd);
+}
+
+/**
+ * @brief Function to read the result of the command sent by
+ * sht4x_start_measurement().
  */
-esp_err_t sht4x_measure_medium_precision_ticks(sht4x_t *const me,
-		                                           uint16_t *temp_ticks,
-																							 uint16_t *hum_ticks) {
+esp_err_t sht4x_read_result(sht4x_t *const me, bool poll, uint16_t *temp_ticks,
+		                        uint16_t *hum_ticks) {
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
-	/* Get temperature and humidity ticks */
-	if (i2c_write(SHT4X_MEASURE_MEDIUM_PRECISION_TICKS_CMD, NULL, 0, me->i2c_dev) < 0) {
-		return ESP_FAIL;
-	}
+	sht4x_frame_t frame;
+	uint8_t cmd = 0;
 
-	delay_us(5 * 1000); /* Wait for 5 ms */
+	ret = read_frame(me, poll, &frame, &cmd);
 
-	uint8_t data_rx[6] = {0};
-	if (i2c_read(0, data_rx, 6, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	if (ret != ESP_OK) {
+		return ret;
 	}
 
 	/* Check data received CRC */
-	for (uint8_t i = 0; i < 6; i += 3) {
-		if (!check_crc(&data_rx[i], 2, data_rx[i + 2])) {
-			return ESP_FAIL;
-		}
+	if (!sht4x_check_frame(&frame)) {
+		STATS_ADD(me, crc_errors, 1);
+		return SHT4X_ERR_CRC;
+	}
+
+	*temp_ticks = (uint16_t)((frame.data[0] << 8) | (frame.data[1]));
+	*hum_ticks = (uint16_t)((frame.data[3] << 8) | (frame.data[4]));
+
+	me->result_flags = result_flags(me, cmd);
+
+	/* Keep the serial number, it never changes */
+	if (cmd == SHT4X_SERIAL_NUMBER_CMD) {
+		me->serial_number = sht4x_serial_number_from_words(*temp_ticks,
+				*hum_ticks);
+		me->serial_valid = true;
 	}
 
-	*temp_ticks = (uint16_t)((data_rx[0] << 8) | (data_rx[1]));
-	*hum_ticks = (uint16_t)((data_rx[3] << 8) | (data_rx[4]));
+#if CONFIG_SHT4X_RESULT_CACHE
+	cache_store(me, cmd, *temp_ticks, *hum_ticks);
+#endif
 
 	/* Return ESP_OK */
 	return ret;
 }
 
 /**
- * @brief Function for a single shot measurement with lowest repeatability.
+ * @brief Function to get the SHT4X_RECORD_FLAG_* bits of the last result
+ * read.
+ */
+uint8_t sht4x_get_result_flags(const sht4x_t *me) {
+	return me->result_flags;
+}
+
+/**
+ * @brief Function to get the earliest time a heater command is accepted.
+ */
+int64_t sht4x_get_heater_ready_time(const sht4x_t *me) {
+	return me->heater_ready_us;
+}
+
+/**
+ * @brief Function to perform back-to-back measurements into an array of
+ * records.
  */
-esp_err_t sht4x_measure_lowest_precision_ticks(sht4x_t *const me,
-		                                           uint16_t *temp_ticks,
-																							 uint16_t *hum_ticks) {
+esp_err_t sht4x_measure_records(sht4x_t *const me, uint8_t cmd,
+		                            sht4x_record_t *records, size_t records_num) {
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
-	/* Get temperature and humidity ticks */
-	if (i2c_write(SHT4X_MEASURE_LOWEST_PRECISION_TICKS_CMD, NULL, 0, me->i2c_dev) < 0) {
-		return ESP_FAIL;
-	}
-
-	delay_us(2 * 1000); /* Wait for 2 ms */
+	for (size_t i = 0; i < records_num; i++) {
+		sht4x_record_t *record = &records[i];
 
-	uint8_t data_rx[6] = {0};
-	if (i2c_read(0, data_rx, 6, me->i2c_dev) < 0) {
-		return ESP_FAIL;
-	}
+		record->status = sht4x_execute(me, cmd, &record->temp_ticks,
+				&record->hum_ticks);
+		record->timestamp_us = esp_timer_get_time();
+		record->flags = record->status == ESP_OK ? me->result_flags : 0;
 
-	/* Check data received CRC */
-	for (uint8_t i = 0; i < 6; i += 3) {
-		if (!check_crc(&data_rx[i], 2, data_rx[i + 2])) {
-			return ESP_FAIL;
+		if (record->status != ESP_OK) {
+			ret = ESP_FAIL;
 		}
 	}
 
-	*temp_ticks = (uint16_t)((data_rx[0] << 8) | (data_rx[1]));
-	*hum_ticks = (uint16_t)((data_rx[3] << 8) | (data_rx[4]));
-
 	/* Return ESP_OK */
 	return ret;
 }
 
 /**
- * @brief Function to activate highest heater power and perform a single
- * shot high precision measurement for 1s.
+ * @brief Function to perform back-to-back measurements into an array of raw
+ * frames.
  */
-esp_err_t sht4x_activate_highest_heater_power_long_ticks(sht4x_t *const me,
-		                                                     uint16_t *temp_ticks,
-																												 uint16_t *hum_ticks) {
+esp_err_t sht4x_measure_frames(sht4x_t *const me, uint8_t cmd,
+		                           sht4x_frame_t *frames, size_t frames_num) {
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
-	/* Get temperature and humidity ticks */
-	if (i2c_write(SHT4X_ACTIVATE_HIGHEST_HEATER_POWER_LONG_TICKS_CMD, NULL, 0, me->i2c_dev) < 0) {
-		return ESP_FAIL;
-	}
+	for (size_t i = 0; i < frames_num; i++) {
+		int64_t ready_time_us = 0;
 
-	delay_us(1100 * 1000); /* Wait for 1100 ms */
+		ret = sht4x_start_measurement(me, cmd, &ready_time_us);
 
-	uint8_t data_rx[6] = {0};
-	if (i2c_read(0, data_rx, 6, me->i2c_dev) < 0) {
-		return ESP_FAIL;
-	}
+		if (ret != ESP_OK) {
+			return ret;
+		}
 
-	/* Check data received CRC */
-	for (uint8_t i = 0; i < 6; i += 3) {
-		if (!check_crc(&data_rx[i], 2, data_rx[i + 2])) {
-			return ESP_FAIL;
+		sht4x_wait_until(me, ready_time_us);
+
+		ret = sht4x_read_frame(me, false, &frames[i]);
+
+		if (ret != ESP_OK) {
+			return ret;
 		}
 	}
 
-	*temp_ticks = (uint16_t)((data_rx[0] << 8) | (data_rx[1]));
-	*hum_ticks = (uint16_t)((data_rx[3] << 8) | (data_rx[4]));
-
 	/* Return ESP_OK */
 	return ret;
 }
 
 /**
- * @brief Function to activate highest heater power and perform a single
- * shot high precision measurement for 0.1s.
+ * @brief Function to wait, using the instance wait mode, until a given time.
+ */
+void sht4x_wait_until(sht4x_t *const me, int64_t time_us) {
+	int64_t remaining = time_us - esp_timer_get_time();
+
+	if (remaining > 0) {
+		wait_us(me, (uint32_t)remaining);
+	}
+}
+
+/**
+ * @brief Function to execute any command.
  */
-esp_err_t sht4x_activate_highest_heater_power_short_ticks(sht4x_t *const me,
-		                                                      uint16_t *temp_ticks,
-																													uint16_t *hum_ticks) {
+esp_err_t sht4x_execute(sht4x_t *const me, uint8_t cmd, uint16_t *temp_ticks,
+		                    uint16_t *hum_ticks) {
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
-	/* Get temperature and humidity ticks */
-	if (i2c_write(SHT4X_ACTIVATE_HIGHEST_HEATER_POWER_SHORT_TICKS_CMD, NULL, 0, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	int64_t start_us = esp_timer_get_time();
+
+	/* Read the response */
+	uint16_t words[2] = {0};
+
+#if CONFIG_SHT4X_THREAD_SAFE
+	const cmd_desc_t *desc = get_cmd_desc(cmd);
+
+	LOCK(me);
+
+	/* Share the result of the same measurement started by another task */
+	if (desc != NULL && desc->precision > 0 && me->pending &&
+			me->pending_cmd == cmd && me->owner != NULL &&
+			me->owner != xTaskGetCurrentTaskHandle()) {
+		uint32_t seq = me->done_seq;
+
+		while (me->done_seq == seq) {
+			wait_release(me);
+		}
+
+		bool shared = me->done_cmd == cmd;
+
+		if (shared) {
+			ret = me->done_status;
+
+			if (ret == ESP_OK && !sht4x_check_frame(&me->done_frame)) {
+				ret = SHT4X_ERR_CRC;
+			}
+
+			words[0] = (uint16_t)((me->done_frame.data[0] << 8) | me->done_frame.data[1]);
+			words[1] = (uint16_t)((me->done_frame.data[3] << 8) | me->done_frame.data[4]);
+		}
+
+		UNLOCK(me);
+
+		if (shared) {
+			if (ret == ESP_OK && temp_ticks != NULL) {
+				*temp_ticks = words[0];
+			}
+
+			if (ret == ESP_OK && hum_ticks != NULL) {
+				*hum_ticks = words[1];
+			}
+
+			return ret;
+		}
+	}
+	else {
+		UNLOCK(me);
 	}
+#endif
 
-	delay_us(110 * 1000); /* Wait for 110 ms */
+	/* Send the command and wait for it to finish */
+	int64_t ready_time_us = 0;
 
-	uint8_t data_rx[6] = {0};
-	if (i2c_read(0, data_rx, 6, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	ret = sht4x_start_measurement(me, cmd, &ready_time_us);
+
+	if (ret != ESP_OK) {
+		return ret;
 	}
 
-	/* Check data received CRC */
-	for (uint8_t i = 0; i < 6; i += 3) {
-		if (!check_crc(&data_rx[i], 2, data_rx[i + 2])) {
-			return ESP_FAIL;
+	if (!me->pending) {
+		sht4x_wait_until(me, ready_time_us);
+		stats_latency(me, start_us);
+		return ret;
+	}
+
+	ret = ESP_ERR_NOT_FINISHED;
+
+	/* Poll the sensor from its typical execution time on, backing off */
+	if (me->poll_interval_us > 0) {
+		int64_t poll_time_us = ready_time_us - sht4x_get_command_duration_us(cmd) +
+				get_cmd_desc(cmd)->typical_us;
+		uint32_t interval_us = me->poll_interval_us;
+
+		while (ret == ESP_ERR_NOT_FINISHED && poll_time_us < ready_time_us) {
+			sht4x_wait_until(me, poll_time_us);
+			ret = sht4x_read_result(me, true, &words[0], &words[1]);
+			poll_time_us = esp_timer_get_time() + interval_us;
+			interval_us *= 2;
 		}
 	}
 
-	*temp_ticks = (uint16_t)((data_rx[0] << 8) | (data_rx[1]));
-	*hum_ticks = (uint16_t)((data_rx[3] << 8) | (data_rx[4]));
+	/* Wait for the maximum execution time */
+	if (ret == ESP_ERR_NOT_FINISHED) {
+		sht4x_wait_until(me, ready_time_us);
+		ret = sht4x_read_result(me, false, &words[0], &words[1]);
+	}
+
+	if (ret != ESP_OK) {
+		return ret;
+	}
+
+	if (temp_ticks != NULL) {
+		*temp_ticks = words[0];
+	}
+
+	if (hum_ticks != NULL) {
+		*hum_ticks = words[1];
+	}
+
+	stats_latency(me, start_us);
 
 	/* Return ESP_OK */
 	return ret;
 }
 
+#if CONFIG_SHT4X_FLOAT_API
 /**
- * @brief Function to activate medium heater power and perform a single
- * shot high precision measurement for 1s.
+ * @brief Function to execute a measurement command and convert the result to
+ * degrees centigrade and percent relative humidity.
  */
-
-esp_err_t sht4x_activate_medium_heater_power_long_ticks(sht4x_t *const me,
-		                                                    uint16_t *temp_ticks,
-																												uint16_t *hum_ticks) {
+esp_err_t sht4x_measure(sht4x_t *const me, uint8_t cmd, float *temp,
+		                    float *hum) {
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
 	/* Get temperature and humidity ticks */
-	if (i2c_write(SHT4X_ACTIVATE_MEDIUM_HEATER_POWER_LONG_TICKS_CMD, NULL, 0, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	uint16_t temp_ticks = 0;
+	uint16_t hum_ticks = 0;
+
+	ret = sht4x_execute(me, cmd, &temp_ticks, &hum_ticks);
+
+	if (ret != ESP_OK) {
+		return ret;
 	}
 
-	delay_us(1100 * 1000); /* Wait for 1100 ms */
+	/* Calculate physical temperature and humidity values */
+	*temp = sht4x_convert_ticks_to_celsius(temp_ticks);
+	*hum = sht4x_convert_ticks_to_percent_rh(hum_ticks);
+
+	/* Return ESP_OK */
+	return ret;
+}
+#endif /* CONFIG_SHT4X_FLOAT_API */
+
+/**
+ * @brief Function to perform several back-to-back conversions and average
+ * their ticks.
+ */
+esp_err_t sht4x_oversample(sht4x_t *const me, uint8_t cmd, size_t samples,
+		                       sht4x_record_t *record) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	const cmd_desc_t *desc = get_cmd_desc(cmd);
 
-	uint8_t data_rx[6] = {0};
-	if (i2c_read(0, data_rx, 6, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	if (desc == NULL || desc->precision == 0 || samples == 0 || samples > 256) {
+		return ESP_ERR_INVALID_ARG;
 	}
 
-	/* Check data received CRC */
-	for (uint8_t i = 0; i < 6; i += 3) {
-		if (!check_crc(&data_rx[i], 2, data_rx[i + 2])) {
-			return ESP_FAIL;
+	uint32_t temp_sum = 0;
+	uint32_t hum_sum = 0;
+	uint8_t flags = 0;
+
+	for (size_t i = 0; i < samples; i++) {
+		uint16_t temp_ticks = 0;
+		uint16_t hum_ticks = 0;
+
+		ret = sht4x_execute(me, cmd, &temp_ticks, &hum_ticks);
+
+		if (ret != ESP_OK) {
+			break;
 		}
+
+		temp_sum += temp_ticks;
+		hum_sum += hum_ticks;
+		flags |= me->result_flags;
 	}
 
-	*temp_ticks = (uint16_t)((data_rx[0] << 8) | (data_rx[1]));
-	*hum_ticks = (uint16_t)((data_rx[3] << 8) | (data_rx[4]));
+	record->timestamp_us = esp_timer_get_time();
+	record->status = ret;
+	record->flags = flags;
+
+	if (ret != ESP_OK) {
+		return ret;
+	}
+
+	/* Round to the nearest tick */
+	record->temp_ticks = (uint16_t)((temp_sum + samples / 2) / samples);
+	record->hum_ticks = (uint16_t)((hum_sum + samples / 2) / samples);
 
 	/* Return ESP_OK */
 	return ret;
 }
 
+#if CONFIG_SHT4X_FILTER
 /**
- * @brief Function to activate medium heater power and perform a single
- * shot high precision measurement for 0.1s.
+ * @brief Function to select the filter of both channels of
+ * sht4x_measure_filtered().
  */
-esp_err_t sht4x_activate_medium_heater_power_short_ticks(sht4x_t *const me,
-		                                                     uint16_t *temp_ticks,
-																												 uint16_t *hum_ticks) {
+esp_err_t sht4x_set_filter(sht4x_t *const me, sht4x_filter_type_t type,
+		                       uint8_t param) {
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
-	/* Get temperature and humidity ticks */
-	if (i2c_write(SHT4X_ACTIVATE_MEDIUM_HEATER_POWER_SHORT_TICKS_CMD, NULL, 0, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	ret = sht4x_filter_init(&me->temp_filter, type, param);
+
+	if (ret != ESP_OK) {
+		return ret;
 	}
 
-	delay_us(110 * 1000); /* Wait for 110 ms */
+	ret = sht4x_filter_init(&me->hum_filter, type, param);
 
-	uint8_t data_rx[6] = {0};
-	if (i2c_read(0, data_rx, 6, me->i2c_dev) < 0) {
-		return ESP_FAIL;
-	}
+	/* Return ESP_OK */
+	return ret;
+}
 
-	/* Check data received CRC */
-	for (uint8_t i = 0; i < 6; i += 3) {
-		if (!check_crc(&data_rx[i], 2, data_rx[i + 2])) {
-			return ESP_FAIL;
-		}
+/**
+ * @brief Function to execute a measurement command and feed its ticks to the
+ * instance filters.
+ */
+esp_err_t sht4x_measure_filtered(sht4x_t *const me, uint8_t cmd,
+		                             sht4x_record_t *record) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	uint16_t temp_ticks = 0;
+	uint16_t hum_ticks = 0;
+
+	ret = sht4x_execute(me, cmd, &temp_ticks, &hum_ticks);
+
+	record->timestamp_us = esp_timer_get_time();
+	record->status = ret;
+	record->flags = 0;
+
+	if (ret != ESP_OK) {
+		return ret;
 	}
 
-	*temp_ticks = (uint16_t)((data_rx[0] << 8) | (data_rx[1]));
-	*hum_ticks = (uint16_t)((data_rx[3] << 8) | (data_rx[4]));
+	record->temp_ticks = sht4x_filter_update(&me->temp_filter, temp_ticks);
+	record->hum_ticks = sht4x_filter_update(&me->hum_filter, hum_ticks);
+	record->flags = me->result_flags;
 
 	/* Return ESP_OK */
 	return ret;
 }
+#endif /* CONFIG_SHT4X_FILTER */
 
+#if CONFIG_SHT4X_MILLI_API
 /**
- * @brief Function to activate lowest heater power and perform a single
- * shot high precision measurement for 1s.
+ * @brief Function to execute a measurement command and convert the result to
+ * thousandths of a degree centigrade and thousandths of a percent relative
+ * humidity.
  */
-esp_err_t sht4x_activate_lowest_heater_power_long_ticks(sht4x_t *const me,
-		                                                    uint16_t *temp_ticks,
-																												uint16_t *hum_ticks) {
+esp_err_t sht4x_measure_milli(sht4x_t *const me, uint8_t cmd, int32_t *temp,
+		                          int32_t *hum) {
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
 	/* Get temperature and humidity ticks */
-	if (i2c_write(SHT4X_ACTIVATE_LOWEST_HEATER_POWER_LONG_TICKS_CMD, NULL, 0, me->i2c_dev) < 0) {
-		return ESP_FAIL;
-	}
+	uint16_t temp_ticks = 0;
+	uint16_t hum_ticks = 0;
 
-	delay_us(1100 * 1000); /* Wait for 1100 ms */
+	ret = sht4x_execute(me, cmd, &temp_ticks, &hum_ticks);
 
-	uint8_t data_rx[6] = {0};
-	if (i2c_read(0, data_rx, 6, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	if (ret != ESP_OK) {
+		return ret;
 	}
 
-	/* Check data received CRC */
-	for (uint8_t i = 0; i < 6; i += 3) {
-		if (!check_crc(&data_rx[i], 2, data_rx[i + 2])) {
-			return ESP_FAIL;
+	/* Calculate physical temperature and humidity values */
+	*temp = sht4x_convert_ticks_to_milli_celsius(temp_ticks);
+	*hum = sht4x_convert_ticks_to_milli_percent_rh(hum_ticks);
+
+	/* Return ESP_OK */
+	return ret;
+}
+#endif /* CONFIG_SHT4X_MILLI_API */
+
+/**
+ * @brief Read out the serial number
+ */
+esp_err_t sht4x_get_serial_number(sht4x_t *const me, uint32_t *serial_number) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	/* Get the serial number, read_result() caches it */
+	if (!me->serial_valid) {
+		uint16_t words[2] = {0};
+
+		ret = sht4x_execute(me, SHT4X_SERIAL_NUMBER_CMD, &words[0], &words[1]);
+
+		if (ret != ESP_OK) {
+			return ret;
 		}
 	}
 
-	*temp_ticks = (uint16_t)((data_rx[0] << 8) | (data_rx[1]));
-	*hum_ticks = (uint16_t)((data_rx[3] << 8) | (data_rx[4]));
+	*serial_number = me->serial_number;
 
 	/* Return ESP_OK */
 	return ret;
 }
 
 /**
- * @brief Function to activate lowest heater power and perform a single
- * shot high precision measurement for 0.1s.
+ * @brief Perform a soft reset.
+ */
+esp_err_t sht4x_soft_reset(sht4x_t *const me) {
+	/* Perform a software reset */
+	esp_err_t ret = sht4x_execute(me, SHT4X_SOFT_RESET_CMD, NULL, NULL);
+
+	if (ret == ESP_OK) {
+		sht4x_discard_state(me);
+	}
+
+	return ret;
+}
+
+/**
+ * @brief Function to discard the state kept about a sensor reset by other
+ * means
+ */
+void sht4x_discard_state(sht4x_t *const me) {
+	LOCK(me);
+	claim(me);
+
+	clear_state(me);
+	me->pending_cmd = SHT4X_SOFT_RESET_CMD;
+	me->ready_time_us = esp_timer_get_time() +
+			sht4x_get_command_duration_us(SHT4X_SOFT_RESET_CMD);
+
+	release(me, ESP_OK, NULL);
+	UNLOCK(me);
+
+#if CONFIG_SHT4X_RESULT_CACHE
+	sht4x_invalidate_cache(me);
+#endif
+}
+
+/**
+ * @brief Function to get the time the sensor needs to execute a command
  */
-esp_err_t sht4x_activate_lowest_heater_power_short_ticks(sht4x_t *const me,
-		                                                     uint16_t *temp_ticks,
-																												 uint16_t *hum_ticks) {
+uint32_t sht4x_get_command_duration_us(uint8_t cmd) {
+	const cmd_desc_t *desc = get_cmd_desc(cmd);
+
+	if (desc == NULL) {
+		return 0;
+	}
+
+	/* Add the configured safety margin */
+	return desc->duration_us + (desc->duration_us / 100) *
+			CONFIG_SHT4X_TIMING_MARGIN_PERCENT;
+}
+
+/**
+ * @brief Function to get the typical time the sensor needs to execute a command
+ */
+uint32_t sht4x_get_command_typical_us(uint8_t cmd) {
+	const cmd_desc_t *desc = get_cmd_desc(cmd);
+
+	return desc == NULL ? 0 : desc->typical_us;
+}
+
+/**
+ * @brief Function to know whether a command turns the heater on
+ */
+bool sht4x_is_heater_command(uint8_t cmd) {
+	const cmd_desc_t *desc = get_cmd_desc(cmd);
+
+	return desc != NULL && desc->heater;
+}
+
+#if CONFIG_SHT4X_I2C_MASTER
+/**
+ * @brief Function to switch the I2C device to asynchronous mode
+ */
+esp_err_t sht4x_async_enable(sht4x_t *const me) {
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
-	/* Get temperature and humidity ticks */
-	if (i2c_write(SHT4X_ACTIVATE_LOWEST_HEATER_POWER_SHORT_TICKS_CMD, NULL, 0, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	if (me->async_enabled) {
+		return ret;
 	}
 
-	delay_us(110 * 1000); /* Wait for 110 ms */
+	/* Only the I2C master driver transport supports asynchronous mode */
+	if (me->i2c_dev == NULL) {
+		return ESP_ERR_NOT_SUPPORTED;
+	}
+
+	/* Create the conversion timer */
+	const esp_timer_create_args_t timer_args = {
+			.callback = async_timer_cb,
+			.arg = me,
+			.dispatch_method = ESP_TIMER_TASK,
+			.name = "sht4x_async"
+	};
+
+	ret = esp_timer_create(&timer_args, &me->async_timer);
 
-	uint8_t data_rx[6] = {0};
-	if (i2c_read(0, data_rx, 6, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to create async timer");
+		return ret;
 	}
 
-	/* Check data received CRC */
-	for (uint8_t i = 0; i < 6; i += 3) {
-		if (!check_crc(&data_rx[i], 2, data_rx[i + 2])) {
-			return ESP_FAIL;
-		}
+	/* Registering a callback switches the device to asynchronous mode */
+	const i2c_master_event_callbacks_t cbs = {
+			.on_trans_done = async_trans_done_cb
+	};
+
+	ret = i2c_master_register_event_callbacks(me->i2c_dev, &cbs, me);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to register I2C callbacks");
+		esp_timer_delete(me->async_timer);
+		me->async_timer = NULL;
+		return ret;
 	}
 
-	*temp_ticks = (uint16_t)((data_rx[0] << 8) | (data_rx[1]));
-	*hum_ticks = (uint16_t)((data_rx[3] << 8) | (data_rx[4]));
+	me->async_state = ASYNC_STATE_IDLE;
+	me->async_enabled = true;
 
 	/* Return ESP_OK */
 	return ret;
 }
 
 /**
- * @brief Read out the serial number
+ * @brief Function to switch the I2C device back to synchronous mode
  */
-esp_err_t sht4x_get_serial_number(sht4x_t *const me, uint32_t *serial_number) {
+esp_err_t sht4x_async_disable(sht4x_t *const me) {
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
-	/* Get temperature the serial number */
-	if (i2c_write(SHT4X_SERIAL_NUMBER_CMD, NULL, 0, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	if (!me->async_enabled) {
+		return ret;
+	}
+
+	/* Keep measurements from starting while the callbacks are removed */
+	if (!async_take(me)) {
+		return ESP_ERR_INVALID_STATE;
 	}
 
-	delay_us(10 * 1000); /* Wait for 10 ms */
+	const i2c_master_event_callbacks_t cbs = {
+			.on_trans_done = NULL
+	};
+
+	ret = i2c_master_register_event_callbacks(me->i2c_dev, &cbs, NULL);
 
-	uint8_t data_rx[6] = {0};
-	if (i2c_read(0, data_rx, 6, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to unregister I2C callbacks");
+		__atomic_store_n(&me->async_state, ASYNC_STATE_IDLE, __ATOMIC_RELEASE);
+		return ret;
 	}
 
-	/* Check data received CRC */
-	for (uint8_t i = 0; i < 6; i += 3) {
-		if (!check_crc(&data_rx[i], 2, data_rx[i + 2])) {
-			return ESP_FAIL;
-		}
+	esp_timer_delete(me->async_timer);
+	me->async_timer = NULL;
+	me->async_enabled = false;
+	__atomic_store_n(&me->async_state, ASYNC_STATE_IDLE, __ATOMIC_RELEASE);
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+/**
+ * @brief Function to perform a measurement without blocking any task.
+ */
+esp_err_t sht4x_async_measure(sht4x_t *const me, uint8_t cmd,
+		                          sht4x_async_cb_t cb, void *cb_arg) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	const cmd_desc_t *desc = get_cmd_desc(cmd);
+
+	if (desc == NULL || cb == NULL) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	/* Synchronous commands are rejected by the transport meanwhile */
+	if (!me->async_enabled || !async_take(me)) {
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	ret = heater_check(me, desc);
+
+	if (ret != ESP_OK) {
+		__atomic_store_n(&me->async_state, ASYNC_STATE_IDLE, __ATOMIC_RELEASE);
+		return ret;
 	}
 
-	*serial_number = (uint32_t)((data_rx[0] << 8) | (data_rx[1]) | (data_rx[3] << 8) | (data_rx[4]));
+	/* The command byte must outlive the queued transaction */
+	memset(&me->async_frame, 0, sizeof(me->async_frame));
+	me->async_cmd = cmd;
+
+	/* Precompute what the ISR path needs, it must not touch flash */
+	me->async_wait_us = sht4x_get_command_duration_us(cmd);
+	me->async_rx_len = desc->rx_len;
+	me->async_flags = result_flags(me, cmd);
+	me->async_cb = cb;
+	me->async_cb_arg = cb_arg;
+
+	ret = classify_i2c_err(i2c_master_transmit(me->i2c_dev, &me->async_cmd, 1,
+			me->timeout_ms));
+
+	if (ret != ESP_OK) {
+		__atomic_store_n(&me->async_state, ASYNC_STATE_IDLE, __ATOMIC_RELEASE);
+		return ret;
+	}
+
+	heater_commit(me, desc);
 
 	/* Return ESP_OK */
 	return ret;
 }
+#endif /* CONFIG_SHT4X_I2C_MASTER */
 
+#if CONFIG_SHT4X_RESULT_CACHE
 /**
- * @brief Perform a soft reset.
+ * @brief Function to get the last measurement result if it is fresh enough.
  */
-esp_err_t sht4x_soft_reset(sht4x_t *const me) {
+bool sht4x_get_cached(sht4x_t *const me, uint8_t cmd, uint32_t max_age_us,
+		                  sht4x_record_t *record) {
+	const cmd_desc_t *desc = get_cmd_desc(cmd);
+
+	if (desc == NULL || desc->precision == 0) {
+		return false;
+	}
+
+	bool hit = false;
+
+	portENTER_CRITICAL(&me->cache_lock);
+
+	const cmd_desc_t *cached = get_cmd_desc(me->cache_cmd);
+
+	if (cached != NULL && cached->precision >= desc->precision &&
+			esp_timer_get_time() - me->cache.timestamp_us <= (int64_t)max_age_us) {
+		*record = me->cache;
+		hit = true;
+	}
+
+	portEXIT_CRITICAL(&me->cache_lock);
+
+	return hit;
+}
+
+/**
+ * @brief Function to get a measurement result no older than max_age_us.
+ */
+esp_err_t sht4x_measure_cached(sht4x_t *const me, uint8_t cmd,
+		                           uint32_t max_age_us, sht4x_record_t *record) {
 	/* Variable to return error code */
 	esp_err_t ret = ESP_OK;
 
-	/* Perform a software reset */
-	if (i2c_write(SHT4X_SOFT_RESET_CMD, NULL, 0, me->i2c_dev) < 0) {
-		return ESP_FAIL;
+	const cmd_desc_t *desc = get_cmd_desc(cmd);
+
+	if (desc == NULL || desc->precision == 0) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	if (sht4x_get_cached(me, cmd, max_age_us, record)) {
+		return ret;
 	}
 
-	delay_us(10 * 1000); /* Wait for 10 ms */
+	/* Only one caller converts, the others wait here for its result */
+	xSemaphoreTake(me->cache_mutex, portMAX_DELAY);
+
+	if (!sht4x_get_cached(me, cmd, max_age_us, record)) {
+		ret = sht4x_execute(me, cmd, &record->temp_ticks, &record->hum_ticks);
+		record->timestamp_us = esp_timer_get_time();
+		record->status = ret;
+		record->flags = ret == ESP_OK ? me->result_flags : 0;
+	}
+
+	xSemaphoreGive(me->cache_mutex);
 
 	/* Return ESP_OK */
 	return ret;
 }
 
+/**
+ * @brief Function to discard the cached measurement result
+ */
+void sht4x_invalidate_cache(sht4x_t *const me) {
+	portENTER_CRITICAL(&me->cache_lock);
+	me->cache_cmd = 0;
+	portEXIT_CRITICAL(&me->cache_lock);
+}
+#endif /* CONFIG_SHT4X_RESULT_CACHE */
+
+#if CONFIG_SHT4X_STATS
+/**
+ * @brief Function to get a consistent snapshot of the instance statistics
+ */
+void sht4x_get_stats(sht4x_t *const me, sht4x_stats_t *stats) {
+	portENTER_CRITICAL(&me->stats_lock);
+	*stats = me->stats;
+	portEXIT_CRITICAL(&me->stats_lock);
+
+	stats->latency_avg_us = stats->commands > 0 ?
+			(uint32_t)(stats->latency_sum_us / stats->commands) : 0;
+}
+
+/**
+ * @brief Function to clear the instance statistics
+ */
+void sht4x_reset_stats(sht4x_t *const me) {
+	portENTER_CRITICAL(&me->stats_lock);
+	memset(&me->stats, 0, sizeof(me->stats));
+	me->stats.latency_min_us = UINT32_MAX;
+	portEXIT_CRITICAL(&me->stats_lock);
+}
+#endif /* CONFIG_SHT4X_STATS */
+
+/**
+ * @brief Function that generates the CRC-8 of a given data
+ */
+uint8_t SHT4X_IRAM_ATTR sht4x_crc8(const uint8_t *data, size_t len) {
+	uint8_t crc = CRC8_INIT;
+
+	for (size_t i = 0; i < len; i++) {
+#if CONFIG_SHT4X_CRC_TABLE_FULL
+		crc = crc8_table[crc ^ data[i]];
+#elif CONFIG_SHT4X_CRC_TABLE_NIBBLE
+		crc ^= data[i];
+		crc = (uint8_t)(crc << 4) ^ crc8_table[crc >> 4];
+		crc = (uint8_t)(crc << 4) ^ crc8_table[crc >> 4];
+#else
+		crc ^= data[i];
+
+		for (uint8_t crc_bit = 8; crc_bit > 0; --crc_bit) {
+			if (crc & 0x80) {
+				crc = (crc << 1) ^ CRC8_POLYNOMIAL;
+			}
+			else {
+				crc = (crc << 1);
+			}
+		}
+#endif
+	}
+
+	return crc;
+}
+
+/**
+ * @brief Function that checks both CRCs of a raw response
+ */
+bool SHT4X_IRAM_ATTR sht4x_check_frame(const sht4x_frame_t *frame) {
+	return sht4x_crc8(&frame->data[0], 2) == frame->data[2] &&
+			sht4x_crc8(&frame->data[3], 2) == frame->data[5];
+}
+
+/**
+ * @brief Function that checks the CRCs of an array of raw responses
+ */
+size_t SHT4X_IRAM_ATTR sht4x_check_frames(const sht4x_frame_t *frames,
+		                                      size_t frames_num, bool *valid) {
+	size_t valid_num = 0;
+
+	for (size_t i = 0; i < frames_num; i++) {
+		bool frame_valid = sht4x_check_frame(&frames[i]);
+
+		if (valid != NULL) {
+			valid[i] = frame_valid;
+		}
+
+		valid_num += frame_valid;
+	}
+
+	return valid_num;
+}
+
 /* Private function definitions ----------------------------------------------*/
+#if CONFIG_SHT4X_I2C_MASTER
 /**
  * @brief Function that implements the default I2C read transaction
  */
-static int8_t i2c_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t data_len,
-		                   void *intf) {
-	i2c_master_dev_handle_t i2c_dev = (i2c_master_dev_handle_t)intf;
+static esp_err_t i2c_read(uint8_t reg_addr, uint8_t *reg_data,
+		                      uint32_t data_len, void *intf) {
+	sht4x_t *const me = (sht4x_t *)intf;
 
-	if (i2c_master_receive(i2c_dev, reg_data, data_len, -1) != ESP_OK) {
-		return -1;
+	/* The device is lost if it could not be added back by set_speed() */
+	if (me->async_enabled || me->i2c_dev == NULL) {
+		return ESP_ERR_INVALID_STATE;
 	}
 
-	return 0;
+	return classify_i2c_err(i2c_master_receive(me->i2c_dev, reg_data, data_len,
+			me->timeout_ms));
 }
 
 /**
  * @brief Function that implements the default I2C write transaction
  */
-static int8_t i2c_write(uint8_t reg_addr, const uint8_t *reg_data,
-		                    uint32_t data_len, void *intf) {
-	i2c_master_dev_handle_t i2c_dev = (i2c_master_dev_handle_t)intf;
+static esp_err_t i2c_write(uint8_t reg_addr, const uint8_t *reg_data,
+		                       uint32_t data_len, void *intf) {
+	sht4x_t *const me = (sht4x_t *)intf;
 
-	if (i2c_master_transmit(i2c_dev, &reg_addr, 1, -1) != ESP_OK) {
-		return -1;
+	/* The device is lost if it could not be added back by set_speed() */
+	if (me->async_enabled || me->i2c_dev == NULL) {
+		return ESP_ERR_INVALID_STATE;
 	}
 
-	return 0;
+	return classify_i2c_err(i2c_master_transmit(me->i2c_dev, &reg_addr, 1,
+			me->timeout_ms));
+}
+#endif /* CONFIG_SHT4X_I2C_MASTER */
+
+/**
+ * @brief Function that sets the defaults and creates the resources shared by
+ * every transport
+ */
+static esp_err_t init_instance(sht4x_t *const me) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	/* Select the default timeout and wait mode */
+	me->timeout_ms = CONFIG_SHT4X_I2C_TIMEOUT_MS;
+	me->poll_interval_us = CONFIG_SHT4X_NACK_POLL_INTERVAL_US;
+	me->ready_time_us = 0;
+	me->serial_number = 0;
+	clear_state(me);
+	me->async_enabled = false;
+#if CONFIG_SHT4X_STATS
+	portMUX_INITIALIZE(&me->stats_lock);
+	sht4x_reset_stats(me);
+#endif
+#if CONFIG_SHT4X_FILTER
+	sht4x_filter_init(&me->temp_filter, SHT4X_FILTER_NONE, 0);
+	sht4x_filter_init(&me->hum_filter, SHT4X_FILTER_NONE, 0);
+#endif
+	me->async_state = ASYNC_STATE_IDLE;
+	me->async_timer = NULL;
+	me->wait_timer = NULL;
+	me->wait_sem = NULL;
+#if CONFIG_SHT4X_PM_LOCK
+	me->pm_lock = NULL;
+#endif
+#if CONFIG_SHT4X_THREAD_SAFE
+	me->lock = NULL;
+	me->done_sem = NULL;
+#endif
+#if CONFIG_SHT4X_RESULT_CACHE
+	me->cache_mutex = NULL;
+#endif
+
+#if CONFIG_SHT4X_PM_LOCK
+	/* Keep the APB clock stable during transfers only */
+	ret = esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "sht4x", &me->pm_lock);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to create the power management lock");
+		free_instance(me);
+		return ret;
+	}
+#endif
+
+#if CONFIG_SHT4X_THREAD_SAFE
+	/* Create the locking resources */
+	me->owner = NULL;
+	me->waiters = 0;
+	me->done_seq = 0;
+	me->done_cmd = 0;
+	me->lock = xSemaphoreCreateMutex();
+	me->done_sem = xSemaphoreCreateCounting(WAITERS_MAX, 0);
+
+	if (me->lock == NULL || me->done_sem == NULL) {
+		ESP_LOGE(TAG, "Failed to create the instance lock");
+		free_instance(me);
+		return ESP_ERR_NO_MEM;
+	}
+#endif
+
+#if CONFIG_SHT4X_RESULT_CACHE
+	/* Start with an empty cache */
+	me->cache_cmd = 0;
+	portMUX_INITIALIZE(&me->cache_lock);
+	me->cache_mutex = xSemaphoreCreateMutex();
+
+	if (me->cache_mutex == NULL) {
+		ESP_LOGE(TAG, "Failed to create the cache mutex");
+		free_instance(me);
+		return ESP_ERR_NO_MEM;
+	}
+#endif
+
+#if defined(CONFIG_SHT4X_WAIT_MODE_TIMER)
+	ret = sht4x_set_wait_mode(me, SHT4X_WAIT_MODE_TIMER);
+#elif defined(CONFIG_SHT4X_WAIT_MODE_LIGHT_SLEEP)
+	ret = sht4x_set_wait_mode(me, SHT4X_WAIT_MODE_LIGHT_SLEEP);
+#elif defined(CONFIG_SHT4X_WAIT_MODE_BUSY)
+	ret = sht4x_set_wait_mode(me, SHT4X_WAIT_MODE_BUSY);
+#else
+	ret = sht4x_set_wait_mode(me, SHT4X_WAIT_MODE_DELAY);
+#endif
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to set the wait mode");
+		free_instance(me);
+		return ret;
+	}
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+static void clear_state(sht4x_t *const me) {
+	me->pending = false;
+	me->result_flags = 0;
+	me->heater_ready_us = 0;
+	me->heater_recovery_us = 0;
+	me->serial_valid = false;
+}
+
+static void free_instance(sht4x_t *const me) {
+	/* Release the wait mode resources */
+	if (me->wait_timer != NULL) {
+		esp_timer_stop(me->wait_timer);
+		esp_timer_delete(me->wait_timer);
+		me->wait_timer = NULL;
+	}
+
+	if (me->wait_sem != NULL) {
+		vSemaphoreDelete(me->wait_sem);
+		me->wait_sem = NULL;
+	}
+
+#if CONFIG_SHT4X_RESULT_CACHE
+	if (me->cache_mutex != NULL) {
+		vSemaphoreDelete(me->cache_mutex);
+		me->cache_mutex = NULL;
+	}
+#endif
+
+#if CONFIG_SHT4X_THREAD_SAFE
+	if (me->done_sem != NULL) {
+		vSemaphoreDelete(me->done_sem);
+		me->done_sem = NULL;
+	}
+
+	if (me->lock != NULL) {
+		vSemaphoreDelete(me->lock);
+		me->lock = NULL;
+	}
+#endif
+
+#if CONFIG_SHT4X_PM_LOCK
+	if (me->pm_lock != NULL) {
+		esp_pm_lock_delete(me->pm_lock);
+		me->pm_lock = NULL;
+	}
+#endif
+}
+
+#if CONFIG_SHT4X_I2C_MASTER
+/**
+ * @brief Function that adds the device to its bus again with another SCL
+ * frequency
+ */
+static esp_err_t set_speed(sht4x_t *const me, uint32_t scl_speed_hz) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	if (scl_speed_hz == me->i2c_dev_conf.scl_speed_hz) {
+		return ret;
+	}
+
+	/* The SCL frequency of a device is fixed when it is added */
+	if (me->i2c_dev != NULL) {
+		ret = i2c_master_bus_rm_device(me->i2c_dev);
+
+		if (ret != ESP_OK) {
+			return ret;
+		}
+	}
+
+	uint32_t old_speed_hz = me->i2c_dev_conf.scl_speed_hz;
+
+	me->i2c_dev_conf.scl_speed_hz = scl_speed_hz;
+
+	ret = i2c_master_bus_add_device(me->i2c_bus, &me->i2c_dev_conf,
+			&me->i2c_dev);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to add device to I2C bus");
+
+		/* Add the device back with the previous frequency */
+		me->i2c_dev_conf.scl_speed_hz = old_speed_hz;
+
+		if (i2c_master_bus_add_device(me->i2c_bus, &me->i2c_dev_conf,
+				&me->i2c_dev) != ESP_OK) {
+			ESP_LOGE(TAG, "Failed to restore the device, instance unusable");
+			me->i2c_dev = NULL;
+		}
+
+		return ret;
+	}
+
+	/* Return ESP_OK */
+	return ret;
 }
 
+/**
+ * @brief Function that maps an I2C master driver error to a driver error
+ */
+static esp_err_t classify_i2c_err(esp_err_t err) {
+	switch (err) {
+		/* Depending on the IDF version a NACK is reported as any of these */
+		case ESP_ERR_INVALID_STATE:
+		case ESP_ERR_INVALID_RESPONSE:
+		case ESP_ERR_NOT_FOUND:
+			return SHT4X_ERR_NACK;
+
+		case ESP_ERR_TIMEOUT:
+			return SHT4X_ERR_TIMEOUT;
+
+		default:
+			return err;
+	}
+}
+#endif /* CONFIG_SHT4X_I2C_MASTER */
+
 /**
  * @brief Function that implements a micro seconds delay
  */
@@ -823,52 +1843,423 @@ static void delay_us(uint32_t period_us) {
 }
 
 /**
- * @brief Convert temperature ticks to physical temperature
+ * @brief Function that waits for the sensor using the instance wait mode
  */
-static float convert_ticks_to_celsius(uint16_t ticks) {
-	return (float)(((float)ticks * 175.0) / 65535.0) - 45.0;
+static void wait_us(sht4x_t *const me, uint32_t period_us) {
+	const int64_t start_us = esp_timer_get_time();
+	const int64_t deadline = start_us + period_us;
+	const int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+	int64_t remaining = period_us;
+
+	/* Block while the remaining time is longer than the spin threshold */
+	while (remaining > CONFIG_SHT4X_WAIT_SPIN_THRESHOLD_US) {
+		if (me->wait_mode == SHT4X_WAIT_MODE_DELAY && remaining >= tick_us) {
+			/* vTaskDelay() never sleeps longer than the ticks asked for, whole
+			 * ticks only so it never overshoots the deadline */
+			vTaskDelay((TickType_t)(remaining / tick_us));
+		}
+		else if ((me->wait_mode == SHT4X_WAIT_MODE_DELAY ||
+				me->wait_mode == SHT4X_WAIT_MODE_TIMER) && me->wait_timer != NULL) {
+			/* Sub-tick remainder of the delay mode or the whole timer mode wait */
+			if (esp_timer_start_once(me->wait_timer, remaining) != ESP_OK) {
+				ESP_LOGW(TAG, "Wait timer busy, spinning for %lld us",
+						(long long)remaining);
+				STATS_ADD(me, wait_fallbacks, 1);
+				break;
+			}
+
+			xSemaphoreTake(me->wait_sem, portMAX_DELAY);
+		}
+#if !CONFIG_IDF_TARGET_LINUX
+		else if (me->wait_mode == SHT4X_WAIT_MODE_LIGHT_SLEEP &&
+				esp_sleep_enable_timer_wakeup(remaining) == ESP_OK) {
+			esp_err_t err = esp_light_sleep_start();
+
+			/* Do not leave the timer armed as a wakeup source of the application */
+			esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+
+			/* Fall back to spinning if the sleep is rejected */
+			if (err != ESP_OK) {
+				break;
+			}
+		}
+#endif
+		else {
+			break;
+		}
+
+		remaining = deadline - esp_timer_get_time();
+	}
+
+	/* Spin for the sub-tick remainder */
+	if (remaining > 0) {
+		delay_us((uint32_t)remaining);
+	}
+
+	STATS_ADD(me, wait_time_us, esp_timer_get_time() - start_us);
 }
 
 /**
- * @brief Convert humidity ticks to physical humidity
+ * @brief Callback of the wait timer, wakes up the task blocked in wait_us()
  */
-static float convert_ticks_to_percent_rh(uint16_t ticks) {
-	return (float)(((float)ticks * 125.0) / 65535.0) - 6.0;
+static void wait_timer_cb(void *arg) {
+	sht4x_t *const me = (sht4x_t *)arg;
+
+	xSemaphoreGive(me->wait_sem);
 }
 
+#if CONFIG_SHT4X_I2C_MASTER
 /**
- * @brief Function that generates a CRC byte for a given data
+ * @brief Callback of the I2C master driver for the asynchronous measurement
  */
-static uint8_t generate_crc(const uint8_t *data, uint16_t count) {
-  uint16_t current_byte;
-  uint8_t crc = CRC8_INIT;
-  uint8_t crc_bit;
+static bool IRAM_ATTR async_trans_done_cb(i2c_master_dev_handle_t i2c_dev,
+		                                      const i2c_master_event_data_t *evt_data,
+																					void *arg) {
+	sht4x_t *const me = (sht4x_t *)arg;
+
+	if (evt_data->event != I2C_EVENT_DONE) {
+		async_finish(me, evt_data->event == I2C_EVENT_NACK ? SHT4X_ERR_NACK :
+				SHT4X_ERR_TIMEOUT);
+		return false;
+	}
 
-  /* calculates 8-Bit checksum with given polynomial */
-  for (current_byte = 0; current_byte < count; ++current_byte) {
-  	crc ^= (data[current_byte]);
+	if (me->async_state == ASYNC_STATE_TX) {
+		/* The conversion starts when the command is acknowledged */
+		me->async_state = ASYNC_STATE_WAIT;
 
-  	for (crc_bit = 8; crc_bit > 0; --crc_bit) {
-  		if (crc & 0x80) {
-  			crc = (crc << 1) ^ CRC8_POLYNOMIAL;
-  		}
-  		else {
-  			crc = (crc << 1);
-  		}
-  	}
-  }
-  return crc;
+		if (esp_timer_start_once(me->async_timer, me->async_wait_us) != ESP_OK) {
+			async_finish(me, ESP_FAIL);
+		}
+	}
+	else if (me->async_state == ASYNC_STATE_RX) {
+		async_finish(me, sht4x_check_frame(&me->async_frame) ? ESP_OK :
+				SHT4X_ERR_CRC);
+	}
+
+	return false;
 }
 
 /**
- * @brief Function that checks the CRC for the received data
+ * @brief Callback of the asynchronous conversion timer, queues the read
  */
-static bool check_crc(const uint8_t *data, uint16_t count, uint8_t checksum) {
-	if (generate_crc(data, count) != checksum) {
-		return false;
+static void async_timer_cb(void *arg) {
+	sht4x_t *const me = (sht4x_t *)arg;
+
+	/* Commands without a response are done once the wait has elapsed */
+	if (me->async_rx_len == 0) {
+		async_finish(me, ESP_OK);
+		return;
+	}
+
+	me->async_state = ASYNC_STATE_RX;
+
+	esp_err_t ret = classify_i2c_err(i2c_master_receive(me->i2c_dev,
+			me->async_frame.data, sizeof(me->async_frame.data), me->timeout_ms));
+
+	if (ret != ESP_OK) {
+		async_finish(me, ret);
+	}
+}
+
+/**
+ * @brief Function that ends the asynchronous measurement and delivers the
+ * result
+ */
+static void IRAM_ATTR async_finish(sht4x_t *const me, esp_err_t status) {
+	sht4x_record_t record = {
+			.timestamp_us = esp_timer_get_time(),
+			.status = status
+	};
+
+	if (status == ESP_OK) {
+		record.temp_ticks = (uint16_t)((me->async_frame.data[0] << 8) |
+				me->async_frame.data[1]);
+		record.hum_ticks = (uint16_t)((me->async_frame.data[3] << 8) |
+				me->async_frame.data[4]);
+		record.flags = me->async_flags;
+	}
+
+	/* Read the callback before another measurement may replace it */
+	sht4x_async_cb_t cb = me->async_cb;
+	void *cb_arg = me->async_cb_arg;
+
+	__atomic_store_n(&me->async_state, ASYNC_STATE_IDLE, __ATOMIC_RELEASE);
+	cb(&record, cb_arg);
+}
+
+static bool async_take(sht4x_t *const me) {
+	uint32_t idle = ASYNC_STATE_IDLE;
+
+	return __atomic_compare_exchange_n(&me->async_state, &idle, ASYNC_STATE_TX,
+			false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+#endif /* CONFIG_SHT4X_I2C_MASTER */
+
+static esp_err_t heater_check(const sht4x_t *me, const cmd_desc_t *desc) {
+#if CONFIG_SHT4X_HEATER
+	if (!desc->heater) {
+		return ESP_OK;
+	}
+
+	int64_t now_us = esp_timer_get_time();
+
+	if (now_us < me->heater_ready_us) {
+		ESP_LOGW(TAG, "Heater duty cycle exceeded, retry in %lld ms",
+				(long long)((me->heater_ready_us - now_us) / 1000));
+		return ESP_ERR_INVALID_STATE;
+	}
+#endif /* CONFIG_SHT4X_HEATER */
+
+	return ESP_OK;
+}
+
+static void heater_commit(sht4x_t *const me, const cmd_desc_t *desc) {
+#if CONFIG_SHT4X_HEATER
+	if (!desc->heater) {
+		return;
+	}
+
+	/* Rest long enough for the pulse to stay within the duty cycle */
+	int64_t end_us = esp_timer_get_time() +
+			sht4x_get_command_duration_us(desc->cmd);
+
+	me->heater_ready_us = end_us + (int64_t)desc->typical_us *
+			(100 - CONFIG_SHT4X_HEATER_MAX_DUTY_PERCENT) /
+			CONFIG_SHT4X_HEATER_MAX_DUTY_PERCENT;
+	me->heater_recovery_us = end_us + CONFIG_SHT4X_HEATER_RECOVERY_MS * 1000LL;
+#endif /* CONFIG_SHT4X_HEATER */
+}
+
+static uint8_t result_flags(const sht4x_t *me, uint8_t cmd) {
+#if CONFIG_SHT4X_HEATER
+	const cmd_desc_t *desc = get_cmd_desc(cmd);
+
+	if (desc != NULL && desc->heater) {
+		return SHT4X_RECORD_FLAG_HEATER;
+	}
+
+	if (esp_timer_get_time() < me->heater_recovery_us) {
+		return SHT4X_RECORD_FLAG_HEATER_RECOVERY;
+	}
+#endif /* CONFIG_SHT4X_HEATER */
+
+	return 0;
+}
+
+/**
+ * @brief Function that looks up the descriptor of a command
+ */
+static const cmd_desc_t *get_cmd_desc(uint8_t cmd) {
+	for (size_t i = 0; i < sizeof(cmd_descs) / sizeof(cmd_descs[0]); i++) {
+		if (cmd_descs[i].cmd == cmd) {
+			return &cmd_descs[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void claim(sht4x_t *const me) {
+#if CONFIG_SHT4X_THREAD_SAFE
+	TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+	while (me->owner != NULL && me->owner != self) {
+		wait_release(me);
+	}
+
+	me->owner = self;
+
+	/* A command without response may still be executing */
+	int64_t busy_us = me->ready_time_us - esp_timer_get_time();
+
+	if (busy_us > 0) {
+		UNLOCK(me);
+		wait_us(me, (uint32_t)busy_us);
+		LOCK(me);
+	}
+#endif
+}
+
+static void release(sht4x_t *const me, esp_err_t status,
+		                const sht4x_frame_t *frame) {
+#if CONFIG_SHT4X_THREAD_SAFE
+	me->owner = NULL;
+	me->done_seq++;
+	me->done_cmd = me->pending_cmd;
+	me->done_status = status;
+
+	if (frame != NULL) {
+		me->done_frame = *frame;
+	}
+
+	/* Wake up every waiter */
+	for (; me->waiters > 0; me->waiters--) {
+		xSemaphoreGive(me->done_sem);
+	}
+#endif
+}
+
+#if CONFIG_SHT4X_THREAD_SAFE
+static void wait_release(sht4x_t *const me) {
+	TaskHandle_t owner = me->owner;
+	TickType_t ticks = portMAX_DELAY;
+
+	if (me->timeout_ms >= 0) {
+		int64_t remaining_us = me->ready_time_us - esp_timer_get_time();
+
+		ticks = pdMS_TO_TICKS((remaining_us > 0 ? remaining_us / 1000 : 0) +
+				me->timeout_ms) + 1;
+	}
+
+	/* done_sem cannot count more waiters, poll until the command ends */
+	if (me->waiters >= WAITERS_MAX) {
+		UNLOCK(me);
+		vTaskDelay(1);
+		LOCK(me);
+		return;
+	}
+
+	me->waiters++;
+	UNLOCK(me);
+
+	bool woken = xSemaphoreTake(me->done_sem, ticks) == pdTRUE;
+
+	LOCK(me);
+
+	if (woken) {
+		return;
+	}
+
+	/* Nobody gave the semaphore for this task */
+	if (me->waiters > 0) {
+		me->waiters--;
+	}
+
+	/* Take the command from an owner that never read its result */
+	if (me->owner == owner && esp_timer_get_time() >= me->ready_time_us) {
+		ESP_LOGW(TAG, "Command 0x%02X abandoned by its owner", me->pending_cmd);
+		me->pending = false;
+		release(me, ESP_ERR_TIMEOUT, NULL);
+	}
+}
+#endif
+
+static void stats_bus(sht4x_t *const me, int64_t start_us, esp_err_t err) {
+#if CONFIG_SHT4X_STATS
+	uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+	portENTER_CRITICAL(&me->stats_lock);
+	me->stats.transactions++;
+	me->stats.bus_time_us += elapsed_us;
+
+	if (err == ESP_ERR_NOT_FINISHED) {
+		me->stats.polls++;
+	}
+	else if (err == SHT4X_ERR_NACK) {
+		me->stats.nack_errors++;
+	}
+	else if (err == SHT4X_ERR_TIMEOUT) {
+		me->stats.timeout_errors++;
 	}
 
-	return true;
+	portEXIT_CRITICAL(&me->stats_lock);
+#endif
+}
+
+static void stats_latency(sht4x_t *const me, int64_t start_us) {
+#if CONFIG_SHT4X_STATS
+	uint32_t latency_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+	portENTER_CRITICAL(&me->stats_lock);
+	me->stats.commands++;
+	me->stats.latency_sum_us += latency_us;
+
+	if (latency_us < me->stats.latency_min_us) {
+		me->stats.latency_min_us = latency_us;
+	}
+
+	if (latency_us > me->stats.latency_max_us) {
+		me->stats.latency_max_us = latency_us;
+	}
+
+	portEXIT_CRITICAL(&me->stats_lock);
+#endif
+}
+
+#if CONFIG_SHT4X_RESULT_CACHE
+static void cache_store(sht4x_t *const me, uint8_t cmd, uint16_t temp_ticks,
+		                    uint16_t hum_ticks) {
+	const cmd_desc_t *desc = get_cmd_desc(cmd);
+
+	/* Only plain measurements are reusable */
+	if (desc == NULL || desc->precision == 0) {
+		return;
+	}
+
+	portENTER_CRITICAL(&me->cache_lock);
+	me->cache.timestamp_us = esp_timer_get_time();
+	me->cache.temp_ticks = temp_ticks;
+	me->cache.hum_ticks = hum_ticks;
+	me->cache.status = ESP_OK;
+	me->cache.flags = me->result_flags;
+	me->cache_cmd = cmd;
+	portEXIT_CRITICAL(&me->cache_lock);
+}
+#endif
+
+/**
+ * @brief Function that reads the response of the pending command
+ */
+static esp_err_t read_frame(sht4x_t *const me, bool poll, sht4x_frame_t *frame,
+		                        uint8_t *cmd) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	LOCK(me);
+
+	if (!me->pending) {
+		UNLOCK(me);
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	bool early = esp_timer_get_time() < me->ready_time_us;
+
+	if (early && !poll) {
+		UNLOCK(me);
+		return ESP_ERR_NOT_FINISHED;
+	}
+
+	/* Read the response, the sensor NACKs while it is still busy */
+	int64_t start_us = esp_timer_get_time();
+
+	PM_ACQUIRE(me);
+	ret = me->transport.read(0, frame->data, sizeof(frame->data),
+			me->transport.intf);
+	PM_RELEASE(me);
+
+	if (early && ret == SHT4X_ERR_NACK) {
+		ret = ESP_ERR_NOT_FINISHED;
+	}
+
+	stats_bus(me, start_us, ret);
+
+	if (ret != ESP_OK) {
+		if (ret != ESP_ERR_NOT_FINISHED) {
+			release(me, ret, NULL);
+		}
+
+		UNLOCK(me);
+		return ret;
+	}
+
+	/* Capture the command before another task can start the next one */
+	*cmd = me->pending_cmd;
+	me->pending = false;
+	release(me, ret, frame);
+	UNLOCK(me);
+
+	/* Return ESP_OK */
+	return ret;
 }
 
 /***************************** END OF FILE ************************************/
@@ -0,0 +1,361 @@
+/**
+  ******************************************************************************
+  * @file           : sht4x_convert.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : SHT4x tick conversion helpers
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "sht4x_convert.h"
+
+/* Private macros ------------------------------------------------------------*/
+/* Magnus coefficients over -45 to 60 degrees centigrade */
+#define MAGNUS_A				17.62f
+#define MAGNUS_B				243.12f
+#define MAGNUS_ES0_HPA	6.112f
+
+/* Absolute humidity constant, 100 * M_w / R in g K / (m3 hPa) */
+#define ABS_HUM_K				216.7f
+
+#define LN2							0.69314718f
+#define LOG2E						1.44269504f
+
+/* Lowest humidity used in the logarithm, in percent relative humidity */
+#define RH_MIN					0.01f
+
+/* External variables --------------------------------------------------------*/
+
+/* Private typedef -----------------------------------------------------------*/
+
+/* Private variables ---------------------------------------------------------*/
+
+/* Private function prototypes -----------------------------------------------*/
+#if CONFIG_SHT4X_FLOAT_API
+/**
+ * @brief Function to approximate the natural logarithm of a positive number
+ */
+static float fast_log(float x);
+
+/**
+ * @brief Function to approximate the exponential function
+ */
+static float fast_exp(float x);
+
+/**
+ * @brief Function to get the humidity of a reading in percent relative
+ * humidity clamped to the physical range
+ */
+static float clamped_rh(uint16_t hum_ticks);
+
+/**
+ * @brief Function to compute the saturation term of a reading
+ */
+static void saturation(sht4x_derived_t *const me);
+#endif /* CONFIG_SHT4X_FLOAT_API */
+
+/* Exported functions definitions --------------------------------------------*/
+#if CONFIG_SHT4X_FLOAT_API
+/**
+ * @brief Function to convert an array of temperature ticks to degrees
+ * centigrade
+ */
+void SHT4X_IRAM_ATTR sht4x_convert_celsius_bulk(const uint16_t *restrict ticks,
+		                                            float *restrict out,
+		                                            size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		out[i] = sht4x_convert_ticks_to_celsius(ticks[i]);
+	}
+}
+
+/**
+ * @brief Function to convert an array of temperature ticks to degrees
+ * Fahrenheit
+ */
+void SHT4X_IRAM_ATTR sht4x_convert_fahrenheit_bulk(const uint16_t *restrict ticks,
+		                                               float *restrict out,
+		                                               size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		out[i] = sht4x_convert_ticks_to_fahrenheit(ticks[i]);
+	}
+}
+
+/**
+ * @brief Function to convert an array of humidity ticks to percent relative
+ * humidity
+ */
+void SHT4X_IRAM_ATTR sht4x_convert_percent_rh_bulk(const uint16_t *restrict ticks,
+		                                               float *restrict out,
+		                                               size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		out[i] = sht4x_convert_ticks_to_percent_rh(ticks[i]);
+	}
+}
+
+/**
+ * @brief Function to convert an array of records to degrees centigrade and
+ * percent relative humidity.
+ */
+void SHT4X_IRAM_ATTR sht4x_convert_records(const sht4x_record_t *records,
+		                                       size_t records_num, float *temp,
+		                                       float *hum) {
+	if (temp != NULL) {
+		for (size_t i = 0; i < records_num; i++) {
+			temp[i] = sht4x_convert_ticks_to_celsius(records[i].temp_ticks);
+		}
+	}
+
+	if (hum != NULL) {
+		for (size_t i = 0; i < records_num; i++) {
+			hum[i] = sht4x_convert_ticks_to_percent_rh(records[i].hum_ticks);
+		}
+	}
+}
+
+/**
+ * @brief Function to set the reading the derived quantities are computed
+ * from.
+ */
+void sht4x_derived_update(sht4x_derived_t *const me, uint16_t temp_ticks,
+		                      uint16_t hum_ticks) {
+	if (me->temp_ticks == temp_ticks && me->hum_ticks == hum_ticks) {
+		return;
+	}
+
+	me->temp_ticks = temp_ticks;
+	me->hum_ticks = hum_ticks;
+	me->valid = 0;
+}
+
+/**
+ * @brief Function to get the dew point of the reading
+ */
+float sht4x_derived_get_dew_point(sht4x_derived_t *const me) {
+	if (!(me->valid & SHT4X_DERIVED_DEW_POINT)) {
+		saturation(me);
+
+		/* gamma = ln(RH / 100) + a * T / (b + T) */
+		float gamma = fast_log(clamped_rh(me->hum_ticks) / 100.0f) + me->magnus;
+
+		me->dew_point = MAGNUS_B * gamma / (MAGNUS_A - gamma);
+		me->valid |= SHT4X_DERIVED_DEW_POINT;
+	}
+
+	return me->dew_point;
+}
+
+/**
+ * @brief Function to get the absolute humidity of the reading
+ */
+float sht4x_derived_get_absolute_humidity(sht4x_derived_t *const me) {
+	if (!(me->valid & SHT4X_DERIVED_ABSOLUTE_HUMIDITY)) {
+		saturation(me);
+
+		float temp = sht4x_convert_ticks_to_celsius(me->temp_ticks);
+
+		me->absolute_humidity = ABS_HUM_K * (clamped_rh(me->hum_ticks) / 100.0f) *
+				me->saturation_hpa / (temp + 273.15f);
+		me->valid |= SHT4X_DERIVED_ABSOLUTE_HUMIDITY;
+	}
+
+	return me->absolute_humidity;
+}
+
+/**
+ * @brief Function to get the vapour pressure deficit of the reading
+ */
+float sht4x_derived_get_vpd(sht4x_derived_t *const me) {
+	if (!(me->valid & SHT4X_DERIVED_VPD)) {
+		saturation(me);
+
+		/* hPa to kPa */
+		me->vpd = me->saturation_hpa * (1.0f - clamped_rh(me->hum_ticks) / 100.0f) /
+				10.0f;
+		me->valid |= SHT4X_DERIVED_VPD;
+	}
+
+	return me->vpd;
+}
+
+/**
+ * @brief Function to compute the derived quantities of arrays of ticks
+ */
+void sht4x_convert_derived_bulk(const uint16_t *temp_ticks,
+		                            const uint16_t *hum_ticks, size_t len,
+																float *dew_point, float *absolute_humidity,
+																float *vpd) {
+	for (size_t i = 0; i < len; i++) {
+		sht4x_derived_t derived = {0};
+
+		derived.temp_ticks = temp_ticks[i];
+		derived.hum_ticks = hum_ticks[i];
+
+		if (dew_point != NULL) {
+			dew_point[i] = sht4x_derived_get_dew_point(&derived);
+		}
+
+		if (absolute_humidity != NULL) {
+			absolute_humidity[i] = sht4x_derived_get_absolute_humidity(&derived);
+		}
+
+		if (vpd != NULL) {
+			vpd[i] = sht4x_derived_get_vpd(&derived);
+		}
+	}
+}
+#endif /* CONFIG_SHT4X_FLOAT_API */
+
+/**
+ * @brief Function to convert an array of temperature ticks to hundredths of a
+ * degree centigrade
+ */
+void SHT4X_IRAM_ATTR sht4x_convert_centi_celsius_bulk(const uint16_t *ticks,
+		                                                  int16_t *out,
+		                                                  size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		out[i] = sht4x_convert_ticks_to_centi_celsius(ticks[i]);
+	}
+}
+
+/**
+ * @brief Function to convert an array of humidity ticks to hundredths of a
+ * percent relative humidity
+ */
+void SHT4X_IRAM_ATTR sht4x_convert_centi_percent_rh_bulk(const uint16_t *ticks,
+		                                                     int16_t *out,
+		                                                     size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		out[i] = sht4x_convert_ticks_to_centi_percent_rh(ticks[i]);
+	}
+}
+
+/**
+ * @brief Function to convert an array of records to thousandths of a degree
+ * centigrade and thousandths of a percent relative humidity
+ */
+void SHT4X_IRAM_ATTR sht4x_convert_records_milli(const sht4x_record_t *records,
+		                                             size_t records_num,
+		                                             int32_t *temp, int32_t *hum) {
+	if (temp != NULL) {
+		for (size_t i = 0; i < records_num; i++) {
+			temp[i] = sht4x_convert_ticks_to_milli_celsius(records[i].temp_ticks);
+		}
+	}
+
+	if (hum != NULL) {
+		for (size_t i = 0; i < records_num; i++) {
+			hum[i] = sht4x_convert_ticks_to_milli_percent_rh(records[i].hum_ticks);
+		}
+	}
+}
+
+/* Private function definitions ----------------------------------------------*/
+#if CONFIG_SHT4X_FLOAT_API
+/**
+ * @brief Function to approximate the natural logarithm of a positive number.
+ * x = m * 2^e with m in [1, 2), log2(m) by a degree 4 minimax polynomial.
+ */
+static float fast_log(float x) {
+	union {
+		float f;
+		uint32_t u;
+	} bits = {.f = x};
+
+	int32_t e = (int32_t)((bits.u >> 23) & 0xFF) - 127;
+
+	bits.u = (bits.u & 0x007FFFFF) | 0x3F800000;
+
+	float m = bits.f;
+	float log2_m = -2.4983531f + m * (4.0292114f + m * (-2.0783352f + m *
+			(0.62603218f - m * 0.078440676f)));
+
+	return ((float)e + log2_m) * LN2;
+}
+
+/**
+ * @brief Function to approximate the exponential function. 2^(i + f) with the
+ * integer part in the exponent bits and 2^f by a degree 3 polynomial.
+ */
+static float fast_exp(float x) {
+	float t = x * LOG2E;
+	int32_t i = (int32_t)t;
+
+	if (t < (float)i) {
+		i--;
+	}
+
+	float f = t - (float)i;
+
+	union {
+		float f;
+		uint32_t u;
+	} bits = {.f = 0.99990029f + f * (0.69632477f + f * (0.22469316f + f *
+			0.078967257f))};
+
+	bits.u += (uint32_t)i << 23;
+
+	return bits.f;
+}
+
+/**
+ * @brief Function to get the humidity of a reading in percent relative
+ * humidity clamped to the physical range
+ */
+static float clamped_rh(uint16_t hum_ticks) {
+	float rh = sht4x_convert_ticks_to_percent_rh(hum_ticks);
+
+	if (rh < RH_MIN) {
+		return RH_MIN;
+	}
+
+	if (rh > 100.0f) {
+		return 100.0f;
+	}
+
+	return rh;
+}
+
+/**
+ * @brief Function to compute the saturation term of a reading, shared by
+ * every derived quantity
+ */
+static void saturation(sht4x_derived_t *const me) {
+	if (me->valid & SHT4X_DERIVED_SATURATION) {
+		return;
+	}
+
+	float temp = sht4x_convert_ticks_to_celsius(me->temp_ticks);
+
+	me->magnus = MAGNUS_A * temp / (MAGNUS_B + temp);
+	me->saturation_hpa = MAGNUS_ES0_HPA * fast_exp(me->magnus);
+	me->valid |= SHT4X_DERIVED_SATURATION;
+}
+#endif /* CONFIG_SHT4X_FLOAT_API */
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,183 @@
+/**
+  ******************************************************************************
+  * @file           : sht4x_filter.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : SHT4x streaming tick filters
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "sht4x_filter.h"
+
+#if CONFIG_SHT4X_FILTER
+/* Private macros ------------------------------------------------------------*/
+#define EMA_SHIFT_MAX	15
+
+/* External variables --------------------------------------------------------*/
+
+/* Private typedef -----------------------------------------------------------*/
+
+/* Private variables ---------------------------------------------------------*/
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that computes the median of the samples in the window
+ *
+ * @param me : Pointer to a sht4x_filter_t instance
+ *
+ * @return Median ticks
+ */
+static uint16_t window_median(const sht4x_filter_t *me);
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function to initialize a tick filter
+ */
+esp_err_t sht4x_filter_init(sht4x_filter_t *const me, sht4x_filter_type_t type,
+		                        uint8_t param) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	switch (type) {
+		case SHT4X_FILTER_NONE:
+			break;
+		case SHT4X_FILTER_BOX:
+		case SHT4X_FILTER_MEDIAN:
+			if (param == 0 || param > SHT4X_FILTER_WINDOW_MAX) {
+				return ESP_ERR_INVALID_ARG;
+			}
+			break;
+		case SHT4X_FILTER_EMA:
+			if (param == 0 || param > EMA_SHIFT_MAX) {
+				return ESP_ERR_INVALID_ARG;
+			}
+			break;
+		default:
+			return ESP_ERR_INVALID_ARG;
+	}
+
+	me->type = type;
+	me->param = param;
+	sht4x_filter_reset(me);
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+/**
+ * @brief Function to discard the history of a tick filter
+ */
+void sht4x_filter_reset(sht4x_filter_t *const me) {
+	me->count = 0;
+	me->index = 0;
+	me->acc = 0;
+}
+
+/**
+ * @brief Function to feed a sample to a tick filter.
+ */
+uint16_t sht4x_filter_update(sht4x_filter_t *const me, uint16_t ticks) {
+	switch (me->type) {
+		case SHT4X_FILTER_BOX:
+			/* Keep a running sum, the oldest sample leaves as the new one enters */
+			if (me->count == me->param) {
+				me->acc -= me->window[me->index];
+			}
+			else {
+				me->count++;
+			}
+
+			me->acc += ticks;
+			me->window[me->index] = ticks;
+			me->index = (uint8_t)((me->index + 1) % me->param);
+
+			return (uint16_t)((me->acc + me->count / 2) / me->count);
+		case SHT4X_FILTER_EMA: {
+			uint32_t sample = (uint32_t)ticks << 16;
+
+			/* Start from the first sample instead of ramping up from zero */
+			if (me->count == 0) {
+				me->acc = sample;
+				me->count = 1;
+			}
+			else if (sample >= me->acc) {
+				me->acc += (sample - me->acc) >> me->param;
+			}
+			else {
+				me->acc -= (me->acc - sample) >> me->param;
+			}
+
+			return (uint16_t)((me->acc + 0x8000) >> 16);
+		}
+		case SHT4X_FILTER_MEDIAN:
+			me->window[me->index] = ticks;
+			me->index = (uint8_t)((me->index + 1) % me->param);
+
+			if (me->count < me->param) {
+				me->count++;
+			}
+
+			return window_median(me);
+		default:
+			return ticks;
+	}
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that computes the median of the samples in the window
+ */
+static uint16_t window_median(const sht4x_filter_t *me) {
+	uint16_t sorted[SHT4X_FILTER_WINDOW_MAX];
+
+	/* Insertion sort, the window is small */
+	for (uint8_t i = 0; i < me->count; i++) {
+		uint16_t value = me->window[i];
+		uint8_t j = i;
+
+		while (j > 0 && sorted[j - 1] > value) {
+			sorted[j] = sorted[j - 1];
+			j--;
+		}
+
+		sorted[j] = value;
+	}
+
+	/* Average the two middle samples of an even window */
+	if ((me->count & 1) == 0) {
+		return (uint16_t)(((uint32_t)sorted[me->count / 2 - 1] +
+				sorted[me->count / 2] + 1) / 2);
+	}
+
+	return sorted[me->count / 2];
+}
+#endif /* CONFIG_SHT4X_FILTER */
+
+/***************************** END OF FILE ************************************/
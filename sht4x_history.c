@@ -0,0 +1,658 @@
+/**
+  ******************************************************************************
+  * @file           : sht4x_history.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : SHT4x compressed reading history
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "sht4x_history.h"
+
+#if CONFIG_SHT4X_HISTORY
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+/* Private macros ------------------------------------------------------------*/
+/* Largest encoded reading: two 18-bit varints, a 32-bit varint and flags */
+#define SAMPLE_LEN_MAX	12
+
+#define ZIGZAG(d)		((uint32_t)(((d) << 1) ^ ((d) >> 31)))
+#define UNZIGZAG(z)	((int32_t)((z) >> 1) ^ -(int32_t)((z) & 1))
+
+_Static_assert(offsetof(sht4x_history_block_t, data) == SHT4X_HISTORY_HEADER_LEN,
+		"sht4x_history_block_t header is not SHT4X_HISTORY_HEADER_LEN bytes");
+_Static_assert(CONFIG_SHT4X_HISTORY_BLOCK_SIZE % 8 == 0,
+		"CONFIG_SHT4X_HISTORY_BLOCK_SIZE must be a multiple of 8");
+_Static_assert(sizeof(sht4x_history_block_t) == CONFIG_SHT4X_HISTORY_BLOCK_SIZE,
+		"sht4x_history_block_t is not CONFIG_SHT4X_HISTORY_BLOCK_SIZE bytes");
+
+/* External variables --------------------------------------------------------*/
+
+/* Private typedef -----------------------------------------------------------*/
+static const char *TAG = "sht4x_history";
+
+/* Private variables ---------------------------------------------------------*/
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that appends a reading to the open block
+ *
+ * @param me     : Pointer to a sht4x_history_t instance
+ * @param record : Reading to append
+ *
+ * @return True on success or False if a new block has to be started
+ */
+static bool encode(sht4x_history_t *const me, const sht4x_record_t *record);
+
+/**
+ * @brief Function that starts a new block with a reading as keyframe
+ *
+ * @param me     : Pointer to a sht4x_history_t instance
+ * @param record : Keyframe reading
+ *
+ * @return ESP_OK on success, an error code if the oldest block could not be
+ * spilled
+ */
+static esp_err_t start_block(sht4x_history_t *const me,
+		                         const sht4x_record_t *record);
+
+/**
+ * @brief Function that frees the oldest RAM block, spilling it to the
+ * partition if there is one
+ *
+ * @param me : Pointer to a sht4x_history_t instance
+ *
+ * @return ESP_OK on success, an error code if the block could not be spilled
+ */
+static esp_err_t evict(sht4x_history_t *const me);
+
+/**
+ * @brief Function that writes a block to the next partition slot, erasing
+ * the oldest blocks of the sector when the partition is full
+ *
+ * @param me    : Pointer to a sht4x_history_t instance
+ * @param block : Block to write
+ *
+ * @return ESP_OK on success, an error code otherwise
+ */
+static esp_err_t spill(sht4x_history_t *const me,
+		                   const sht4x_history_block_t *block);
+
+/**
+ * @brief Function that gets the oldest block, reading it back from the
+ * partition if needed
+ *
+ * @param me : Pointer to a sht4x_history_t instance
+ *
+ * @return Pointer to the block or NULL if the history is empty
+ */
+static const sht4x_history_block_t *oldest(sht4x_history_t *const me);
+
+/**
+ * @brief Function that removes the oldest block
+ *
+ * @param me : Pointer to a sht4x_history_t instance
+ */
+static void release_oldest(sht4x_history_t *const me);
+
+/**
+ * @brief Function that decodes the next reading of a block
+ *
+ * @param block  : Pointer to the block
+ * @param cursor : Decoder state, zeroed to start at the keyframe
+ * @param record : Pointer to store the reading
+ *
+ * @return True on success or False at the end of the block or if it is
+ * corrupted
+ */
+static bool decode_next(const sht4x_history_block_t *block,
+		                    sht4x_history_cursor_t *cursor,
+												sht4x_record_t *record);
+
+/**
+ * @brief Function that stores a varint
+ *
+ * @param data  : Pointer to store the varint
+ * @param value : Value to encode
+ *
+ * @return Number of bytes stored
+ */
+static size_t put_varint(uint8_t *data, uint32_t value);
+
+/**
+ * @brief Function that loads a varint from a block
+ *
+ * @param block  : Pointer to the block
+ * @param offset : Offset of the varint, advanced past it
+ * @param value  : Pointer to store the value
+ *
+ * @return True on success or False if the varint runs past the block data
+ */
+static bool get_varint(const sht4x_history_block_t *block, uint16_t *offset,
+		                   uint32_t *value);
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function to initialize a history store
+ */
+esp_err_t sht4x_history_init(sht4x_history_t *const me,
+		                         const sht4x_history_config_t *config) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	if (config == NULL || config->blocks_num == 0) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	memset(me, 0, sizeof(*me));
+	me->config = *config;
+
+	/* Find the spill partition */
+	if (config->partition_label != NULL) {
+		me->partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+				ESP_PARTITION_SUBTYPE_ANY, config->partition_label);
+
+		if (me->partition == NULL) {
+			ESP_LOGE(TAG, "Partition %s not found", config->partition_label);
+			return ESP_ERR_NOT_FOUND;
+		}
+
+		if (me->partition->erase_size % CONFIG_SHT4X_HISTORY_BLOCK_SIZE != 0) {
+			ESP_LOGE(TAG, "Block size does not divide the erase size");
+			return ESP_ERR_INVALID_SIZE;
+		}
+
+		/* Only whole sectors are used */
+		me->flash_slots = (me->partition->size / me->partition->erase_size) *
+				(me->partition->erase_size / CONFIG_SHT4X_HISTORY_BLOCK_SIZE);
+
+		if (me->flash_slots == 0) {
+			ESP_LOGE(TAG, "Partition %s is too small", config->partition_label);
+			return ESP_ERR_INVALID_SIZE;
+		}
+	}
+
+	me->blocks = calloc(config->blocks_num, sizeof(sht4x_history_block_t));
+
+	if (me->blocks == NULL) {
+		ESP_LOGE(TAG, "Failed to allocate the history blocks");
+		return ESP_ERR_NO_MEM;
+	}
+
+	me->mutex = xSemaphoreCreateMutex();
+
+	if (me->mutex == NULL) {
+		ESP_LOGE(TAG, "Failed to create the history mutex");
+		free(me->blocks);
+		me->blocks = NULL;
+		return ESP_ERR_NO_MEM;
+	}
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+/**
+ * @brief Function to free the resources of a history store
+ */
+void sht4x_history_deinit(sht4x_history_t *const me) {
+	if (me->mutex != NULL) {
+		vSemaphoreDelete(me->mutex);
+		me->mutex = NULL;
+	}
+
+	free(me->blocks);
+	me->blocks = NULL;
+	me->ram_count = 0;
+	me->flash_count = 0;
+}
+
+/**
+ * @brief Function to append a reading.
+ */
+esp_err_t sht4x_history_append(sht4x_history_t *const me,
+		                           const sht4x_record_t *record) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	if (record->status != ESP_OK) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	xSemaphoreTake(me->mutex, portMAX_DELAY);
+
+	if (me->ram_count == 0 || !encode(me, record)) {
+		ret = start_block(me, record);
+	}
+
+	xSemaphoreGive(me->mutex);
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+/**
+ * @brief Function to read and remove the oldest readings, decoded.
+ */
+size_t sht4x_history_read(sht4x_history_t *const me, sht4x_record_t *records,
+		                      size_t records_num) {
+	size_t records_read = 0;
+
+	xSemaphoreTake(me->mutex, portMAX_DELAY);
+
+	while (records_read < records_num) {
+		const sht4x_history_block_t *block = oldest(me);
+
+		if (block == NULL) {
+			break;
+		}
+
+		while (records_read < records_num && decode_next(block, &me->reader,
+				&records[records_read])) {
+			records_read++;
+		}
+
+		if (records_read == records_num) {
+			break;
+		}
+
+		/* Keep the open block, it still receives readings */
+		if (me->flash_count == 0 && me->ram_count == 1) {
+			break;
+		}
+
+		release_oldest(me);
+	}
+
+	xSemaphoreGive(me->mutex);
+
+	return records_read;
+}
+
+/**
+ * @brief Function to remove the oldest block without decoding it.
+ */
+esp_err_t sht4x_history_pop_block(sht4x_history_t *const me,
+		                              sht4x_history_block_t *block) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	xSemaphoreTake(me->mutex, portMAX_DELAY);
+
+	const sht4x_history_block_t *oldest_block = oldest(me);
+
+	if (oldest_block == NULL) {
+		ret = ESP_ERR_NOT_FOUND;
+	}
+	else {
+		*block = *oldest_block;
+		release_oldest(me);
+	}
+
+	xSemaphoreGive(me->mutex);
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+/**
+ * @brief Function to decode every reading of a block
+ */
+size_t sht4x_history_decode_block(const sht4x_history_block_t *block,
+		                              sht4x_record_t *records, size_t records_num) {
+	sht4x_history_cursor_t cursor = {0};
+	size_t records_read = 0;
+
+	while (records_read < records_num && decode_next(block, &cursor,
+			&records[records_read])) {
+		records_read++;
+	}
+
+	return records_read;
+}
+
+/**
+ * @brief Function to get the amount of blocks overwritten before they were
+ * read
+ */
+uint32_t sht4x_history_get_dropped(sht4x_history_t *const me) {
+	return me->dropped;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that appends a reading to the open block
+ */
+static bool encode(sht4x_history_t *const me, const sht4x_record_t *record) {
+	sht4x_history_cursor_t *writer = &me->writer;
+	sht4x_history_block_t *block = &me->blocks[me->newest_seq %
+			me->config.blocks_num];
+
+	if (block->samples == UINT16_MAX ||
+			SHT4X_HISTORY_DATA_LEN - block->len < SAMPLE_LEN_MAX ||
+			record->timestamp_us < writer->timestamp_us) {
+		return false;
+	}
+
+	int64_t elapsed_ms = (record->timestamp_us - writer->timestamp_us + 500) /
+			1000;
+
+	if (elapsed_ms > UINT32_MAX) {
+		return false;
+	}
+
+	/* Keep the period implicit while the timestamps stay within tolerance */
+	bool meta = record->flags != writer->flags ||
+			llabs(elapsed_ms - (int64_t)writer->period_ms) >
+			me->config.time_tolerance_ms;
+	uint32_t period_ms = meta ? (uint32_t)elapsed_ms : writer->period_ms;
+	int32_t temp_delta = (int32_t)record->temp_ticks - writer->temp_ticks;
+	int32_t hum_delta = (int32_t)record->hum_ticks - writer->hum_ticks;
+	uint8_t *data = &block->data[block->len];
+	size_t len = 0;
+
+	len += put_varint(&data[len], ZIGZAG(temp_delta) << 1 | meta);
+	len += put_varint(&data[len], ZIGZAG(hum_delta));
+
+	if (meta) {
+		len += put_varint(&data[len], period_ms);
+		data[len++] = record->flags;
+	}
+
+	block->len += len;
+	block->samples++;
+
+	/* Track the timestamp the decoder reconstructs, not the real one */
+	writer->sample = block->samples;
+	writer->offset = block->len;
+	writer->timestamp_us += period_ms * 1000LL;
+	writer->period_ms = period_ms;
+	writer->temp_ticks = record->temp_ticks;
+	writer->hum_ticks = record->hum_ticks;
+	writer->flags = record->flags;
+
+	return true;
+}
+
+/**
+ * @brief Function that starts a new block with a reading as keyframe
+ */
+static esp_err_t start_block(sht4x_history_t *const me,
+		                         const sht4x_record_t *record) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	if (me->ram_count == me->config.blocks_num) {
+		ret = evict(me);
+	}
+
+	me->newest_seq++;
+	me->ram_count++;
+
+	sht4x_history_block_t *block = &me->blocks[me->newest_seq %
+			me->config.blocks_num];
+
+	memset(block, 0, SHT4X_HISTORY_HEADER_LEN);
+	block->timestamp_us = record->timestamp_us;
+	block->seq = me->newest_seq;
+	block->temp_ticks = record->temp_ticks;
+	block->hum_ticks = record->hum_ticks;
+	block->samples = 1;
+	block->flags = record->flags;
+
+	me->writer = (sht4x_history_cursor_t) {
+			.sample = 1,
+			.timestamp_us = record->timestamp_us,
+			.temp_ticks = record->temp_ticks,
+			.hum_ticks = record->hum_ticks,
+			.flags = record->flags
+	};
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+/**
+ * @brief Function that frees the oldest RAM block
+ */
+static esp_err_t evict(sht4x_history_t *const me) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	const sht4x_history_block_t *block = &me->blocks[(me->newest_seq -
+			me->ram_count + 1) % me->config.blocks_num];
+
+	if (me->partition != NULL) {
+		ret = spill(me, block);
+	}
+
+	/* The block is lost if it could not be spilled */
+	if (me->partition == NULL || ret != ESP_OK) {
+		if (me->flash_count == 0) {
+			memset(&me->reader, 0, sizeof(me->reader));
+		}
+
+		me->dropped++;
+	}
+
+	me->ram_count--;
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+/**
+ * @brief Function that writes a block to the next partition slot
+ */
+static esp_err_t spill(sht4x_history_t *const me,
+		                   const sht4x_history_block_t *block) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	size_t offset = me->flash_head * CONFIG_SHT4X_HISTORY_BLOCK_SIZE;
+	size_t sector_slots = me->partition->erase_size /
+			CONFIG_SHT4X_HISTORY_BLOCK_SIZE;
+
+	if (offset % me->partition->erase_size == 0) {
+		/* Erasing the sector drops the oldest blocks if the partition is full */
+		if (me->flash_count > me->flash_slots - sector_slots) {
+			size_t lost = me->flash_count - (me->flash_slots - sector_slots);
+
+			me->flash_count -= lost;
+			me->dropped += lost;
+			memset(&me->reader, 0, sizeof(me->reader));
+		}
+
+		ret = esp_partition_erase_range(me->partition, offset,
+				me->partition->erase_size);
+
+		if (ret != ESP_OK) {
+			ESP_LOGE(TAG, "Failed to erase the history sector");
+			return ret;
+		}
+	}
+
+	ret = esp_partition_write(me->partition, offset, block,
+			sizeof(sht4x_history_block_t));
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to write the history block");
+		return ret;
+	}
+
+	me->flash_head = (me->flash_head + 1) % me->flash_slots;
+	me->flash_count++;
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+/**
+ * @brief Function that gets the oldest block
+ */
+static const sht4x_history_block_t *oldest(sht4x_history_t *const me) {
+	if (me->flash_count > 0) {
+		size_t slot = (me->flash_head + me->flash_slots - me->flash_count) %
+				me->flash_slots;
+
+		if (esp_partition_read(me->partition, slot * CONFIG_SHT4X_HISTORY_BLOCK_SIZE,
+				&me->scratch, sizeof(me->scratch)) != ESP_OK) {
+			ESP_LOGE(TAG, "Failed to read the history block");
+			return NULL;
+		}
+
+		return &me->scratch;
+	}
+
+	if (me->ram_count > 0) {
+		return &me->blocks[(me->newest_seq - me->ram_count + 1) %
+				me->config.blocks_num];
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Function that removes the oldest block
+ */
+static void release_oldest(sht4x_history_t *const me) {
+	if (me->flash_count > 0) {
+		me->flash_count--;
+	}
+	else if (me->ram_count > 0) {
+		me->ram_count--;
+	}
+
+	memset(&me->reader, 0, sizeof(me->reader));
+}
+
+/**
+ * @brief Function that decodes the next reading of a block
+ */
+static bool decode_next(const sht4x_history_block_t *block,
+		                    sht4x_history_cursor_t *cursor,
+												sht4x_record_t *record) {
+	if (cursor->sample >= block->samples) {
+		return false;
+	}
+
+	if (cursor->sample == 0) {
+		/* Start at the keyframe */
+		*cursor = (sht4x_history_cursor_t) {
+				.timestamp_us = block->timestamp_us,
+				.temp_ticks = block->temp_ticks,
+				.hum_ticks = block->hum_ticks,
+				.flags = block->flags
+		};
+	}
+	else {
+		uint16_t offset = cursor->offset;
+		uint32_t temp_word = 0;
+		uint32_t hum_word = 0;
+
+		if (!get_varint(block, &offset, &temp_word) ||
+				!get_varint(block, &offset, &hum_word)) {
+			return false;
+		}
+
+		if (temp_word & 1) {
+			if (!get_varint(block, &offset, &cursor->period_ms) ||
+					offset >= block->len) {
+				return false;
+			}
+
+			cursor->flags = block->data[offset++];
+		}
+
+		temp_word >>= 1;
+		cursor->offset = offset;
+		cursor->timestamp_us += cursor->period_ms * 1000LL;
+		cursor->temp_ticks += UNZIGZAG(temp_word);
+		cursor->hum_ticks += UNZIGZAG(hum_word);
+	}
+
+	cursor->sample++;
+
+	record->timestamp_us = cursor->timestamp_us;
+	record->temp_ticks = cursor->temp_ticks;
+	record->hum_ticks = cursor->hum_ticks;
+	record->status = ESP_OK;
+	record->flags = cursor->flags;
+
+	return true;
+}
+
+/**
+ * @brief Function that stores a varint
+ */
+static size_t put_varint(uint8_t *data, uint32_t value) {
+	size_t len = 0;
+
+	while (value >= 0x80) {
+		data[len++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+
+	data[len++] = (uint8_t)value;
+
+	return len;
+}
+
+/**
+ * @brief Function that loads a varint from a block
+ */
+static bool get_varint(const sht4x_history_block_t *block, uint16_t *offset,
+		                   uint32_t *value) {
+	uint32_t result = 0;
+
+	for (uint32_t shift = 0; shift < 32; shift += 7) {
+		if (*offset >= block->len) {
+			return false;
+		}
+
+		uint8_t byte = block->data[(*offset)++];
+
+		result |= (uint32_t)(byte & 0x7F) << shift;
+
+		if (!(byte & 0x80)) {
+			*value = result;
+			return true;
+		}
+	}
+
+	return false;
+}
+#endif /* CONFIG_SHT4X_HISTORY */
+
+/***************************** END OF FILE ************************************/
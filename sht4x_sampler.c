@@ -0,0 +1,631 @@
+/**
+  ******************************************************************************
+  * @file           : sht4x_sampler.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : Background periodic sampling for SHT4x sensors
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "sht4x_sampler.h"
+
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define EVENT_LOOP_QUEUE_SIZE	16
+
+/* Copies of the latest reading attempted before giving up */
+#define LATEST_RETRIES	4
+
+/* Command of the idle state of adaptive sampling */
+#if CONFIG_SHT4X_LOWEST_PRECISION
+#define IDLE_CMD(me)	SHT4X_MEASURE_LOWEST_PRECISION_TICKS_CMD
+#else
+#define IDLE_CMD(me)	((me)->config.cmd)
+#endif
+
+/* External variables --------------------------------------------------------*/
+
+/* Private typedef -----------------------------------------------------------*/
+static const char *TAG = "sht4x_sampler";
+
+/* Private variables ---------------------------------------------------------*/
+ESP_EVENT_DEFINE_BASE(SHT4X_EVENT);
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that implements the sampling task
+ *
+ * @param arg : Pointer to a sht4x_sampler_t instance
+ */
+static void sampler_task(void *arg);
+
+/**
+ * @brief Function that pushes a record to the ring buffer. Only called by
+ * the sampling task.
+ *
+ * @param me     : Pointer to a sht4x_sampler_t instance
+ * @param record : Record to push
+ *
+ * @return True on success or False if the buffer is full
+ */
+static bool ring_push(sht4x_sampler_t *const me, const sht4x_record_t *record);
+
+/**
+ * @brief Function that publishes the latest reading for
+ * sht4x_sampler_get_latest(). Only called by the sampling task.
+ *
+ * @param me     : Pointer to a sht4x_sampler_t instance
+ * @param record : Successful reading
+ */
+static void publish_latest(sht4x_sampler_t *const me,
+		                       const sht4x_record_t *record);
+
+/**
+ * @brief Function that selects the command of the next sample: a requested
+ * heater pulse, a creep compensation pulse or the configured measurement.
+ * Only called by the sampling task.
+ *
+ * @param me : Pointer to a sht4x_sampler_t instance
+ *
+ * @return Command byte
+ */
+static uint8_t next_cmd(sht4x_sampler_t *const me);
+
+/**
+ * @brief Function that tracks how long humidity has been high. Only called
+ * by the sampling task.
+ *
+ * @param me     : Pointer to a sht4x_sampler_t instance
+ * @param record : Last record
+ */
+static void track_humidity(sht4x_sampler_t *const me,
+		                       const sht4x_record_t *record);
+
+/**
+ * @brief Function that switches adaptive sampling between its fast and idle
+ * states. Only called by the sampling task.
+ *
+ * @param me     : Pointer to a sht4x_sampler_t instance
+ * @param record : Last record
+ */
+static void adapt(sht4x_sampler_t *const me, const sht4x_record_t *record);
+
+/**
+ * @brief Function that decides whether a record is delivered to the
+ * consumers. Only called by the sampling task.
+ *
+ * @param me     : Pointer to a sht4x_sampler_t instance
+ * @param record : Last record
+ *
+ * @return True if the record has to be delivered
+ */
+static bool should_report(sht4x_sampler_t *const me,
+		                      const sht4x_record_t *record);
+
+/**
+ * @brief Function that checks whether two readings differ by more than a
+ * band
+ *
+ * @param a         : First reading
+ * @param b         : Second reading
+ * @param temp_band : Temperature band in ticks
+ * @param hum_band  : Humidity band in ticks
+ *
+ * @return True if any of the words differs by more than its band
+ */
+static bool outside_band(const sht4x_record_t *a, const sht4x_record_t *b,
+		                     uint16_t temp_band, uint16_t hum_band);
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function to start a background sampling task
+ */
+esp_err_t sht4x_sampler_start(sht4x_sampler_t *const me, sht4x_t *dev,
+		                          const sht4x_sampler_config_t *config) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	if (dev == NULL || config == NULL || config->period_ms == 0 ||
+			config->buffer_len == 0) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	if (sht4x_get_command_duration_us(config->cmd) == 0) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	if (config->heater_cmd != 0 &&
+			!sht4x_is_heater_command(config->heater_cmd)) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	if (config->adaptive && config->idle_period_ms == 0) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	/* Round the capacity up to a power of two */
+	size_t capacity = 1;
+
+	while (capacity < config->buffer_len) {
+		capacity <<= 1;
+	}
+
+	me->buffer = calloc(capacity, sizeof(sht4x_record_t));
+
+	if (me->buffer == NULL) {
+		ESP_LOGE(TAG, "Failed to allocate the ring buffer");
+		return ESP_ERR_NO_MEM;
+	}
+
+	me->stop_sem = xSemaphoreCreateBinary();
+
+	if (me->stop_sem == NULL) {
+		ESP_LOGE(TAG, "Failed to create the stop semaphore");
+		free(me->buffer);
+		return ESP_ERR_NO_MEM;
+	}
+
+	/* Create a dedicated event loop so slow handlers never delay sampling */
+	me->event_loop = config->post_events ? config->event_loop : NULL;
+	me->event_loop_owned = false;
+
+	if (config->post_events && config->event_loop == NULL) {
+		const esp_event_loop_args_t loop_args = {
+				.queue_size = EVENT_LOOP_QUEUE_SIZE,
+				.task_name = "sht4x_events",
+				.task_priority = config->priority > 1 ? config->priority - 1 : 1,
+				.task_stack_size = config->stack_size,
+				.task_core_id = config->core_id
+		};
+
+		ret = esp_event_loop_create(&loop_args, &me->event_loop);
+
+		if (ret != ESP_OK) {
+			ESP_LOGE(TAG, "Failed to create the event loop");
+			vSemaphoreDelete(me->stop_sem);
+			free(me->buffer);
+			return ret;
+		}
+
+		me->event_loop_owned = true;
+	}
+
+	me->dev = dev;
+	me->config = *config;
+	me->mask = capacity - 1;
+	me->head = 0;
+	me->tail = 0;
+	me->dropped = 0;
+	me->heater_request = 0;
+	me->rh_high_since_us = 0;
+	me->idle = false;
+	me->flat_samples = 0;
+	me->anchor.status = ESP_FAIL;
+	me->reported.status = ESP_FAIL;
+	me->suppressed = 0;
+	me->latest_seq = 0;
+	me->running = true;
+
+	/* Create the sampling task */
+	if (xTaskCreatePinnedToCore(sampler_task, "sht4x_sampler", config->stack_size,
+			me, config->priority, &me->task, config->core_id) != pdPASS) {
+		ESP_LOGE(TAG, "Failed to create the sampling task");
+
+		if (me->event_loop_owned) {
+			esp_event_loop_delete(me->event_loop);
+		}
+
+		vSemaphoreDelete(me->stop_sem);
+		free(me->buffer);
+		return ESP_ERR_NO_MEM;
+	}
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+/**
+ * @brief Function to stop the sampling task and free its resources
+ */
+void sht4x_sampler_stop(sht4x_sampler_t *const me) {
+	if (me->task == NULL) {
+		return;
+	}
+
+	/* Wake up the task and wait until it exits */
+	me->running = false;
+	xTaskNotifyGive(me->task);
+	xSemaphoreTake(me->stop_sem, portMAX_DELAY);
+
+	if (me->event_loop_owned) {
+		esp_event_loop_delete(me->event_loop);
+	}
+
+	vSemaphoreDelete(me->stop_sem);
+	free(me->buffer);
+	me->buffer = NULL;
+	me->event_loop = NULL;
+	me->task = NULL;
+}
+
+/**
+ * @brief Function to request a heater pulse from the sampling task without
+ * blocking.
+ */
+esp_err_t sht4x_sampler_heat(sht4x_sampler_t *const me, uint8_t cmd) {
+	if (!sht4x_is_heater_command(cmd)) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	me->heater_request = cmd;
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+/**
+ * @brief Function to get the event loop the sampler posts to
+ */
+esp_event_loop_handle_t sht4x_sampler_get_event_loop(sht4x_sampler_t *const me) {
+	return me->event_loop;
+}
+
+/**
+ * @brief Function to get the amount of records waiting in the ring buffer
+ */
+size_t sht4x_sampler_available(sht4x_sampler_t *const me) {
+	size_t head = __atomic_load_n(&me->head, __ATOMIC_ACQUIRE);
+	size_t tail = __atomic_load_n(&me->tail, __ATOMIC_RELAXED);
+
+	return head - tail;
+}
+
+/**
+ * @brief Function to drain records from the ring buffer.
+ */
+size_t sht4x_sampler_read(sht4x_sampler_t *const me, sht4x_record_t *records,
+		                      size_t records_num) {
+	size_t head = __atomic_load_n(&me->head, __ATOMIC_ACQUIRE);
+	size_t tail = __atomic_load_n(&me->tail, __ATOMIC_RELAXED);
+	size_t count = 0;
+
+	while (tail != head && count < records_num) {
+		records[count++] = me->buffer[tail & me->mask];
+		tail++;
+	}
+
+	/* Release the slots to the producer */
+	__atomic_store_n(&me->tail, tail, __ATOMIC_RELEASE);
+
+	return count;
+}
+
+/**
+ * @brief Function to get the contiguous block of the oldest records without
+ * copying them.
+ */
+size_t sht4x_sampler_peek(sht4x_sampler_t *const me,
+		                      const sht4x_record_t **records) {
+	size_t head = __atomic_load_n(&me->head, __ATOMIC_ACQUIRE);
+	size_t tail = __atomic_load_n(&me->tail, __ATOMIC_RELAXED);
+	size_t index = tail & me->mask;
+	size_t count = head - tail;
+
+	/* Stop at the end of the storage, the rest is returned by the next call */
+	if (count > me->mask + 1 - index) {
+		count = me->mask + 1 - index;
+	}
+
+	*records = &me->buffer[index];
+
+	return count;
+}
+
+/**
+ * @brief Function to release records obtained with sht4x_sampler_peek()
+ */
+void sht4x_sampler_release(sht4x_sampler_t *const me, size_t records_num) {
+	size_t tail = __atomic_load_n(&me->tail, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&me->tail, tail + records_num, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Function to get the amount of records dropped because the ring
+ * buffer was full
+ */
+uint32_t sht4x_sampler_get_dropped(sht4x_sampler_t *const me) {
+	return __atomic_load_n(&me->dropped, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Function to get the amount of readings not delivered because they
+ * did not change enough
+ */
+uint32_t sht4x_sampler_get_suppressed(sht4x_sampler_t *const me) {
+	return __atomic_load_n(&me->suppressed, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Function to get the last successful reading of the sampler without
+ * locking or blocking.
+ */
+bool IRAM_ATTR sht4x_sampler_get_latest(const sht4x_sampler_t *me,
+		                                    sht4x_record_t *record) {
+	for (uint32_t i = 0; i < LATEST_RETRIES; i++) {
+		uint32_t seq = __atomic_load_n(&me->latest_seq, __ATOMIC_ACQUIRE);
+
+		if (seq == 0) {
+			return false;
+		}
+
+		*record = me->latest[seq & 1];
+
+		/* The copy is consistent if no other reading was published meanwhile */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		if (__atomic_load_n(&me->latest_seq, __ATOMIC_RELAXED) == seq) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that implements the sampling task
+ */
+static void sampler_task(void *arg) {
+	sht4x_sampler_t *const me = (sht4x_sampler_t *)arg;
+	TickType_t last_wake = xTaskGetTickCount();
+
+	while (me->running) {
+		sht4x_record_t record = {0};
+
+		/* Perform the measurement */
+		record.status = sht4x_execute(me->dev, next_cmd(me), &record.temp_ticks,
+				&record.hum_ticks);
+
+		record.timestamp_us = esp_timer_get_time();
+
+		if (record.status == ESP_OK) {
+			record.flags = sht4x_get_result_flags(me->dev);
+			publish_latest(me, &record);
+		}
+
+		track_humidity(me, &record);
+		adapt(me, &record);
+
+		/* Deliver only the readings the consumers asked for */
+		if (!should_report(me, &record)) {
+			__atomic_fetch_add(&me->suppressed, 1, __ATOMIC_RELAXED);
+		}
+		else {
+			ring_push(me, &record);
+
+#if CONFIG_SHT4X_HISTORY
+			if (me->config.history != NULL && record.status == ESP_OK) {
+				sht4x_history_append(me->config.history, &record);
+			}
+#endif
+
+			/* Fan the record out without blocking the sampling */
+			if (me->event_loop != NULL) {
+				sht4x_event_data_t event_data = {
+						.dev = me->dev,
+						.record = record
+				};
+
+				esp_event_post_to(me->event_loop, SHT4X_EVENT, record.status == ESP_OK ?
+						SHT4X_EVENT_READING : SHT4X_EVENT_ERROR, &event_data,
+						sizeof(event_data), 0);
+			}
+		}
+
+		/* Sleep until the next period, sht4x_sampler_stop() wakes the task up */
+		TickType_t period = pdMS_TO_TICKS(me->idle ? me->config.idle_period_ms :
+				me->config.period_ms);
+
+		if (period == 0) {
+			period = 1;
+		}
+		TickType_t elapsed = xTaskGetTickCount() - last_wake;
+
+		if (elapsed < period) {
+			ulTaskNotifyTake(pdTRUE, period - elapsed);
+		}
+
+		last_wake += period;
+
+		/* Do not try to catch up with periods missed, e.g. by heater commands */
+		if (xTaskGetTickCount() - last_wake >= period) {
+			last_wake = xTaskGetTickCount();
+		}
+	}
+
+	xSemaphoreGive(me->stop_sem);
+	vTaskDelete(NULL);
+}
+
+/**
+ * @brief Function that pushes a record to the ring buffer.
+ */
+static bool ring_push(sht4x_sampler_t *const me, const sht4x_record_t *record) {
+	size_t head = __atomic_load_n(&me->head, __ATOMIC_RELAXED);
+	size_t tail = __atomic_load_n(&me->tail, __ATOMIC_ACQUIRE);
+
+	if (head - tail > me->mask) {
+		__atomic_fetch_add(&me->dropped, 1, __ATOMIC_RELAXED);
+		return false;
+	}
+
+	me->buffer[head & me->mask] = *record;
+
+	/* Publish the record to the consumer */
+	__atomic_store_n(&me->head, head + 1, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+/**
+ * @brief Function that publishes the latest reading.
+ */
+static void publish_latest(sht4x_sampler_t *const me,
+		                       const sht4x_record_t *record) {
+	uint32_t seq = me->latest_seq + 1;
+
+	/* Write the buffer readers are not using, then switch them to it. The
+	 * fence keeps the write after the previous switch. */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	me->latest[seq & 1] = *record;
+	__atomic_store_n(&me->latest_seq, seq, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Function that selects the command of the next sample.
+ */
+static uint8_t next_cmd(sht4x_sampler_t *const me) {
+	uint8_t cmd = me->heater_request;
+	int64_t now_us = esp_timer_get_time();
+
+	/* Keep measuring until the heater budget allows the pulse */
+	if (now_us < sht4x_get_heater_ready_time(me->dev)) {
+		return me->idle ? IDLE_CMD(me) :
+				me->config.cmd;
+	}
+
+	if (cmd != 0) {
+		me->heater_request = 0;
+		return cmd;
+	}
+
+	/* Creep compensation: heat when humidity has been high for long */
+	if (me->config.heater_cmd != 0 && me->rh_high_since_us != 0 &&
+			now_us - me->rh_high_since_us >= me->config.heater_hold_ms * 1000LL) {
+		me->rh_high_since_us = 0;
+		return me->config.heater_cmd;
+	}
+
+	return me->idle ? IDLE_CMD(me) : me->config.cmd;
+}
+
+/**
+ * @brief Function that tracks how long humidity has been high.
+ */
+static void track_humidity(sht4x_sampler_t *const me,
+		                       const sht4x_record_t *record) {
+	/* Heated samples read a humidity lower than the real one */
+	if (record->status != ESP_OK || record->flags != 0) {
+		return;
+	}
+
+	if (record->hum_ticks < me->config.heater_rh_ticks) {
+		me->rh_high_since_us = 0;
+	}
+	else if (me->rh_high_since_us == 0) {
+		me->rh_high_since_us = record->timestamp_us;
+	}
+}
+
+/**
+ * @brief Function that switches adaptive sampling between its fast and idle
+ * states.
+ */
+static void adapt(sht4x_sampler_t *const me, const sht4x_record_t *record) {
+	/* Heated samples say nothing about the environment */
+	if (!me->config.adaptive || record->status != ESP_OK || record->flags != 0) {
+		return;
+	}
+
+	/* Escalate on change and re-centre the dead-band on the new reading */
+	if (me->anchor.status != ESP_OK || outside_band(record, &me->anchor,
+			me->config.deadband_temp_ticks, me->config.deadband_hum_ticks)) {
+		if (me->idle) {
+			ESP_LOGD(TAG, "Change detected, sampling fast");
+		}
+
+		me->anchor = *record;
+		me->flat_samples = 0;
+		me->idle = false;
+		return;
+	}
+
+	if (!me->idle && ++me->flat_samples >= me->config.settle_samples) {
+		ESP_LOGD(TAG, "Readings flat, sampling idle");
+		me->idle = true;
+	}
+}
+
+/**
+ * @brief Function that decides whether a record is delivered to the
+ * consumers.
+ */
+static bool should_report(sht4x_sampler_t *const me,
+		                      const sht4x_record_t *record) {
+	const sht4x_record_t *last = &me->reported;
+	bool report = !me->config.report_on_change || record->status != ESP_OK ||
+			last->status != ESP_OK || record->flags != last->flags;
+
+	if (!report && me->config.heartbeat_ms > 0) {
+		report = record->timestamp_us - last->timestamp_us >=
+				me->config.heartbeat_ms * 1000LL;
+	}
+
+	if (!report) {
+		report = outside_band(record, last, me->config.report_temp_ticks,
+				me->config.report_hum_ticks);
+	}
+
+	if (report) {
+		me->reported = *record;
+	}
+
+	return report;
+}
+
+/**
+ * @brief Function that checks whether two readings differ by more than a
+ * band
+ */
+static bool outside_band(const sht4x_record_t *a, const sht4x_record_t *b,
+		                     uint16_t temp_band, uint16_t hum_band) {
+	uint16_t temp_delta = a->temp_ticks > b->temp_ticks ?
+			a->temp_ticks - b->temp_ticks : b->temp_ticks - a->temp_ticks;
+	uint16_t hum_delta = a->hum_ticks > b->hum_ticks ?
+			a->hum_ticks - b->hum_ticks : b->hum_ticks - a->hum_ticks;
+
+	return temp_delta > temp_band || hum_delta > hum_band;
+}
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,301 @@
+/**
+  ******************************************************************************
+  * @file           : sht4x_scheduler.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : Multi-sensor SHT4x conversion scheduler
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "sht4x_scheduler.h"
+
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+/* Private macros ------------------------------------------------------------*/
+
+/* External variables --------------------------------------------------------*/
+
+/* Private typedef -----------------------------------------------------------*/
+static const char *TAG = "sht4x_scheduler";
+
+/* Private variables ---------------------------------------------------------*/
+
+/* Private function prototypes -----------------------------------------------*/
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function to initialize a scheduler instance
+ */
+esp_err_t sht4x_scheduler_init(sht4x_scheduler_t *const me,
+		                           const sht4x_scheduler_config_t *config) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	if (config == NULL || config->devs == NULL || config->devs_num == 0) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	if (sht4x_get_command_duration_us(config->cmd) == 0) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	/* Allocate the results of a sweep */
+	me->records = calloc(config->devs_num, sizeof(sht4x_record_t));
+
+	if (me->records == NULL) {
+		ESP_LOGE(TAG, "Failed to allocate the records");
+		return ESP_ERR_NO_MEM;
+	}
+
+	me->config = *config;
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+/**
+ * @brief Function to deinitialize a scheduler instance
+ */
+void sht4x_scheduler_deinit(sht4x_scheduler_t *const me) {
+	free(me->records);
+	me->records = NULL;
+}
+
+/**
+ * @brief Function to perform one sweep over all the devices.
+ */
+esp_err_t sht4x_scheduler_sweep(sht4x_scheduler_t *const me,
+		                            const sht4x_record_t **records) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	sht4x_t **devs = me->config.devs;
+	int64_t ready_time_us = 0;
+
+	/* Start the conversion on every device back-to-back */
+	for (size_t i = 0; i < me->config.devs_num; i++) {
+		int64_t dev_ready_time_us = 0;
+
+		memset(&me->records[i], 0, sizeof(sht4x_record_t));
+		me->records[i].status = sht4x_start_measurement(devs[i], me->config.cmd,
+				&dev_ready_time_us);
+
+		if (me->records[i].status == ESP_OK && dev_ready_time_us > ready_time_us) {
+			ready_time_us = dev_ready_time_us;
+		}
+	}
+
+	/* Wait once for the longest conversion */
+	sht4x_wait_until(devs[0], ready_time_us);
+
+	/* Read every result */
+	for (size_t i = 0; i < me->config.devs_num; i++) {
+		sht4x_record_t *record = &me->records[i];
+
+		if (record->status == ESP_OK) {
+			record->status = sht4x_read_result(devs[i], false, &record->temp_ticks,
+					&record->hum_ticks);
+			record->timestamp_us = esp_timer_get_time();
+			record->flags = sht4x_get_result_flags(devs[i]);
+		}
+
+		if (record->status != ESP_OK) {
+			ret = ESP_FAIL;
+		}
+	}
+
+	/* Deliver the batch */
+	if (me->config.cb != NULL) {
+		me->config.cb(me->records, me->config.devs_num, me->config.cb_arg);
+	}
+
+	if (me->config.queue != NULL) {
+		for (size_t i = 0; i < me->config.devs_num; i++) {
+			sht4x_scheduler_item_t item = {
+					.dev_index = i,
+					.record = me->records[i]
+			};
+
+			if (xQueueSend(me->config.queue, &item, 0) != pdTRUE) {
+				ESP_LOGW(TAG, "Queue full, result of device %u dropped", (unsigned)i);
+			}
+		}
+	}
+
+	if (records != NULL) {
+		*records = me->records;
+	}
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+#if CONFIG_SHT4X_I2C_MASTER
+/**
+ * @brief Function to reset every device with a single I2C general call per
+ * bus
+ */
+esp_err_t sht4x_scheduler_reset(sht4x_scheduler_t *const me) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	sht4x_t **devs = me->config.devs;
+
+	/* Custom transports have no I2C bus to broadcast on, check them all before
+	 * resetting any bus */
+	for (size_t i = 0; i < me->config.devs_num; i++) {
+		if (devs[i]->i2c_dev == NULL) {
+			return ESP_ERR_NOT_SUPPORTED;
+		}
+	}
+
+	for (size_t i = 0; i < me->config.devs_num; i++) {
+		/* Send the general call once per bus */
+		bool sent = false;
+
+		for (size_t j = 0; j < i; j++) {
+			sent |= devs[j]->i2c_bus == devs[i]->i2c_bus;
+		}
+
+		if (sent) {
+			continue;
+		}
+
+		const i2c_device_config_t dev_conf = {
+				.dev_addr_length = I2C_ADDR_BIT_LEN_7,
+				.device_address = SHT4X_GENERAL_CALL_ADDR,
+				.scl_speed_hz = devs[i]->i2c_dev_conf.scl_speed_hz
+		};
+		i2c_master_dev_handle_t general_call = NULL;
+		const uint8_t cmd = SHT4X_GENERAL_CALL_RESET;
+
+		ret = i2c_master_bus_add_device(devs[i]->i2c_bus, &dev_conf, &general_call);
+
+		if (ret != ESP_OK) {
+			ESP_LOGE(TAG, "Failed to add the general call device");
+			return ret;
+		}
+
+		ret = i2c_master_transmit(general_call, &cmd, 1, devs[i]->timeout_ms);
+		i2c_master_bus_rm_device(general_call);
+
+		if (ret != ESP_OK) {
+			ESP_LOGE(TAG, "Failed to send the general call reset");
+			return ret;
+		}
+	}
+
+	/* Forget what the driver knew about the sensors before the reset */
+	for (size_t i = 0; i < me->config.devs_num; i++) {
+		sht4x_discard_state(devs[i]);
+	}
+
+	/* Wait once for every sensor to come out of reset */
+	sht4x_wait_until(devs[0], esp_timer_get_time() +
+			sht4x_get_command_duration_us(SHT4X_SOFT_RESET_CMD));
+
+	/* Return ESP_OK */
+	return ret;
+}
+#endif /* CONFIG_SHT4X_I2C_MASTER */
+
+/**
+ * @brief Function to read the serial number of every device.
+ */
+esp_err_t sht4x_scheduler_discover(sht4x_scheduler_t *const me,
+		                               sht4x_identity_t *identities) {
+	/* Variable to return error code */
+	esp_err_t ret = ESP_OK;
+
+	sht4x_t **devs = me->config.devs;
+	int64_t ready_time_us = 0;
+
+	/* Start the read on every device back-to-back */
+	for (size_t i = 0; i < me->config.devs_num; i++) {
+		int64_t dev_ready_time_us = 0;
+
+		identities[i].serial_number = 0;
+		identities[i].dev = devs[i];
+		identities[i].status = sht4x_start_measurement(devs[i],
+				SHT4X_SERIAL_NUMBER_CMD, &dev_ready_time_us);
+
+		if (identities[i].status == ESP_OK && dev_ready_time_us > ready_time_us) {
+			ready_time_us = dev_ready_time_us;
+		}
+	}
+
+	/* Wait once for the slowest device */
+	sht4x_wait_until(devs[0], ready_time_us);
+
+	/* Read every serial number */
+	for (size_t i = 0; i < me->config.devs_num; i++) {
+		sht4x_identity_t *identity = &identities[i];
+		uint16_t words[2] = {0};
+
+		if (identity->status == ESP_OK) {
+			identity->status = sht4x_read_result(devs[i], false, &words[0],
+					&words[1]);
+		}
+
+		if (identity->status != ESP_OK) {
+			ret = ESP_FAIL;
+			continue;
+		}
+
+		identity->serial_number = sht4x_serial_number_from_words(words[0],
+				words[1]);
+	}
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+/**
+ * @brief Function to find a device by its cached serial number.
+ */
+sht4x_t *sht4x_scheduler_find(const sht4x_scheduler_t *me,
+		                          uint32_t serial_number) {
+	for (size_t i = 0; i < me->config.devs_num; i++) {
+		sht4x_t *dev = me->config.devs[i];
+
+		if (dev->serial_valid && dev->serial_number == serial_number) {
+			return dev;
+		}
+	}
+
+	return NULL;
+}
+
+/* Private function definitions ----------------------------------------------*/
+
+/***************************** END OF FILE ************************************/
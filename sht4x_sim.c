@@ -0,0 +1,215 @@
+/**
+  ******************************************************************************
+  * @file           : sht4x_sim.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : Simulated SHT4x sensor transport
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "sht4x_sim.h"
+
+#if CONFIG_SHT4X_SIM
+#include "esp_err.h"
+#include "esp_timer.h"
+
+/* Private macros ------------------------------------------------------------*/
+
+/* External variables --------------------------------------------------------*/
+
+/* Private typedef -----------------------------------------------------------*/
+
+/* Private variables ---------------------------------------------------------*/
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that implements the simulated read transaction
+ *
+ * @param reg_addr : Unused
+ * @param reg_data : Pointer to store the response
+ * @param data_len : Length of the response
+ * @param intf     : Pointer to a sht4x_sim_t instance
+ *
+ * @return ESP_OK on success, SHT4X_ERR_NACK or SHT4X_ERR_TIMEOUT on failure
+ */
+static esp_err_t sim_read(uint8_t reg_addr, uint8_t *reg_data,
+		                      uint32_t data_len, void *intf);
+
+/**
+ * @brief Function that implements the simulated write transaction
+ *
+ * @param reg_addr : Command byte
+ * @param reg_data : Unused
+ * @param data_len : Unused
+ * @param intf     : Pointer to a sht4x_sim_t instance
+ *
+ * @return ESP_OK on success, SHT4X_ERR_NACK or SHT4X_ERR_TIMEOUT on failure
+ */
+static esp_err_t sim_write(uint8_t reg_addr, const uint8_t *reg_data,
+		                       uint32_t data_len, void *intf);
+
+/**
+ * @brief Function that checks whether the Nth event has to fail
+ *
+ * @param count : Event number, starting at 1
+ * @param every : Fault period, 0 to disable
+ *
+ * @return True if the event has to fail
+ */
+static bool sim_fault(uint32_t count, uint32_t every);
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function to initialize a simulated sensor without faults
+ */
+void sht4x_sim_init(sht4x_sim_t *const me, uint16_t temp_ticks,
+		                uint16_t hum_ticks, uint32_t serial_number) {
+	me->temp_ticks = temp_ticks;
+	me->hum_ticks = hum_ticks;
+	me->serial_number = serial_number;
+	me->faults.nack_every = 0;
+	me->faults.crc_every = 0;
+	me->faults.timeout_every = 0;
+	me->cmd = 0;
+	me->response = false;
+	me->ready_time_us = 0;
+	me->writes = 0;
+	me->reads = 0;
+	me->transactions = 0;
+}
+
+/**
+ * @brief Function to change the ticks returned by the next measurements
+ */
+void sht4x_sim_set_ticks(sht4x_sim_t *const me, uint16_t temp_ticks,
+		                     uint16_t hum_ticks) {
+	me->temp_ticks = temp_ticks;
+	me->hum_ticks = hum_ticks;
+}
+
+/**
+ * @brief Function to select the faults injected by the simulated sensor
+ */
+void sht4x_sim_set_faults(sht4x_sim_t *const me,
+		                      const sht4x_sim_faults_t *faults) {
+	me->faults = *faults;
+}
+
+/**
+ * @brief Function to get the transport of a simulated sensor
+ */
+void sht4x_sim_get_transport(sht4x_sim_t *const me,
+		                         sht4x_transport_t *transport) {
+	transport->read = sim_read;
+	transport->write = sim_write;
+	transport->intf = me;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/**
+ * @brief Function that implements the simulated read transaction
+ */
+static esp_err_t sim_read(uint8_t reg_addr, uint8_t *reg_data,
+		                      uint32_t data_len, void *intf) {
+	sht4x_sim_t *const me = (sht4x_sim_t *)intf;
+
+	if (sim_fault(++me->transactions, me->faults.timeout_every)) {
+		return SHT4X_ERR_TIMEOUT;
+	}
+
+	/* The sensor NACKs its address while it is busy or has nothing to send */
+	if (!me->response || esp_timer_get_time() < me->ready_time_us ||
+			data_len > 6) {
+		return SHT4X_ERR_NACK;
+	}
+
+	uint16_t words[2] = {me->temp_ticks, me->hum_ticks};
+
+	if (me->cmd == SHT4X_SERIAL_NUMBER_CMD) {
+		words[0] = (uint16_t)(me->serial_number >> 16);
+		words[1] = (uint16_t)me->serial_number;
+	}
+
+	uint8_t frame[6];
+
+	for (uint8_t i = 0; i < 2; i++) {
+		frame[i * 3] = (uint8_t)(words[i] >> 8);
+		frame[i * 3 + 1] = (uint8_t)words[i];
+		frame[i * 3 + 2] = sht4x_crc8(&frame[i * 3], 2);
+	}
+
+	if (sim_fault(++me->reads, me->faults.crc_every)) {
+		frame[2] ^= 0xFF;
+	}
+
+	for (uint32_t i = 0; i < data_len; i++) {
+		reg_data[i] = frame[i];
+	}
+
+	me->response = false;
+
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that implements the simulated write transaction
+ */
+static esp_err_t sim_write(uint8_t reg_addr, const uint8_t *reg_data,
+		                       uint32_t data_len, void *intf) {
+	sht4x_sim_t *const me = (sht4x_sim_t *)intf;
+	int64_t now_us = esp_timer_get_time();
+	uint32_t duration_us = sht4x_get_command_typical_us(reg_addr);
+
+	if (sim_fault(++me->transactions, me->faults.timeout_every)) {
+		return SHT4X_ERR_TIMEOUT;
+	}
+
+	/* Busy sensors and unknown commands are NACKed */
+	if (now_us < me->ready_time_us || duration_us == 0 ||
+			sim_fault(++me->writes, me->faults.nack_every)) {
+		return SHT4X_ERR_NACK;
+	}
+
+	me->cmd = reg_addr;
+	me->response = reg_addr != SHT4X_SOFT_RESET_CMD;
+	me->ready_time_us = now_us + duration_us;
+
+	return ESP_OK;
+}
+
+/**
+ * @brief Function that checks whether the Nth event has to fail
+ */
+static bool sim_fault(uint32_t count, uint32_t every) {
+	return every > 0 && count % every == 0;
+}
+#endif /* CONFIG_SHT4X_SIM */
+
+/***************************** END OF FILE ************************************/
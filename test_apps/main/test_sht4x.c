@@ -0,0 +1,289 @@
+/**
+  ******************************************************************************
+  * @file           : test_sht4x.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : Driver tests against the simulated sensor
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "unity.h"
+
+#include "esp_timer.h"
+
+#include "sht4x.h"
+#include "sht4x_sim.h"
+#include "test_sht4x.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define SIM_TEMP_TICKS	26214
+#define SIM_HUM_TICKS		32768
+#define SIM_SERIAL			0x12345678
+
+/* Private variables ---------------------------------------------------------*/
+static sht4x_sim_t sim;
+static sht4x_t dev;
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that initializes the simulated sensor and an instance on it
+ */
+static void start_device(void);
+
+/**
+ * @brief Function that injects faults in the simulated sensor
+ *
+ * @param nack_every    : NACK every Nth command write, 0 to disable
+ * @param crc_every     : Corrupt every Nth response, 0 to disable
+ * @param timeout_every : Time out every Nth transaction, 0 to disable
+ */
+static void set_faults(uint32_t nack_every, uint32_t crc_every,
+		                   uint32_t timeout_every);
+
+/* Private function definitions ----------------------------------------------*/
+static void test_measure_returns_sensor_ticks(void) {
+	uint16_t temp_ticks = 0;
+	uint16_t hum_ticks = 0;
+
+	start_device();
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_execute(&dev,
+			SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD, &temp_ticks, &hum_ticks));
+	TEST_ASSERT_EQUAL_UINT16(SIM_TEMP_TICKS, temp_ticks);
+	TEST_ASSERT_EQUAL_UINT16(SIM_HUM_TICKS, hum_ticks);
+	TEST_ASSERT_EQUAL_UINT32(1, sim.writes);
+	TEST_ASSERT_EQUAL_UINT32(1, sim.reads);
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_deinit(&dev));
+}
+
+static void test_unknown_command_is_rejected(void) {
+	uint16_t temp_ticks = 0;
+	uint16_t hum_ticks = 0;
+
+	start_device();
+
+	TEST_ASSERT_NOT_EQUAL(ESP_OK, sht4x_execute(&dev, 0x00, &temp_ticks,
+			&hum_ticks));
+	TEST_ASSERT_EQUAL_UINT32(0, sim.writes);
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_deinit(&dev));
+}
+
+static void test_serial_number_is_cached(void) {
+	uint32_t serial_number = 0;
+
+	start_device();
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_get_serial_number(&dev, &serial_number));
+	TEST_ASSERT_EQUAL_HEX32(SIM_SERIAL, serial_number);
+
+	/* The second call must not reach the bus */
+	uint32_t transactions = sim.transactions;
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_get_serial_number(&dev, &serial_number));
+	TEST_ASSERT_EQUAL_HEX32(SIM_SERIAL, serial_number);
+	TEST_ASSERT_EQUAL_UINT32(transactions, sim.transactions);
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_deinit(&dev));
+}
+
+static void test_crc_failure_is_reported(void) {
+	uint16_t temp_ticks = 0;
+	uint16_t hum_ticks = 0;
+
+	start_device();
+	set_faults(0, 2, 0);
+
+	/* Every second response is corrupted */
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_execute(&dev,
+			SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD, &temp_ticks, &hum_ticks));
+	TEST_ASSERT_EQUAL(SHT4X_ERR_CRC, sht4x_execute(&dev,
+			SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD, &temp_ticks, &hum_ticks));
+
+	set_faults(0, 0, 0);
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_execute(&dev,
+			SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD, &temp_ticks, &hum_ticks));
+	TEST_ASSERT_EQUAL_UINT16(SIM_TEMP_TICKS, temp_ticks);
+
+#if CONFIG_SHT4X_STATS
+	sht4x_stats_t stats;
+
+	sht4x_get_stats(&dev, &stats);
+	TEST_ASSERT_EQUAL_UINT32(1, stats.crc_errors);
+#endif
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_deinit(&dev));
+}
+
+static void test_nack_is_reported(void) {
+	uint16_t temp_ticks = 0;
+	uint16_t hum_ticks = 0;
+
+	start_device();
+	set_faults(1, 0, 0);
+
+	TEST_ASSERT_EQUAL(SHT4X_ERR_NACK, sht4x_execute(&dev,
+			SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD, &temp_ticks, &hum_ticks));
+	TEST_ASSERT_EQUAL_UINT32(0, sim.reads);
+
+#if CONFIG_SHT4X_STATS
+	sht4x_stats_t stats;
+
+	sht4x_get_stats(&dev, &stats);
+	TEST_ASSERT_GREATER_OR_EQUAL_UINT32(1, stats.nack_errors);
+#endif
+
+	/* A NACKed command leaves the instance usable */
+	set_faults(0, 0, 0);
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_execute(&dev,
+			SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD, &temp_ticks, &hum_ticks));
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_deinit(&dev));
+}
+
+static void test_timeout_is_reported(void) {
+	uint16_t temp_ticks = 0;
+	uint16_t hum_ticks = 0;
+
+	start_device();
+
+	/* The write goes through, the read of the result times out */
+	set_faults(0, 0, 2);
+
+	TEST_ASSERT_EQUAL(SHT4X_ERR_TIMEOUT, sht4x_execute(&dev,
+			SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD, &temp_ticks, &hum_ticks));
+
+#if CONFIG_SHT4X_STATS
+	sht4x_stats_t stats;
+
+	sht4x_get_stats(&dev, &stats);
+	TEST_ASSERT_GREATER_OR_EQUAL_UINT32(1, stats.timeout_errors);
+#endif
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_deinit(&dev));
+}
+
+static void test_polling_returns_the_result(void) {
+	uint16_t temp_ticks = 0;
+	uint16_t hum_ticks = 0;
+	const uint8_t cmd = SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD;
+
+	start_device();
+	sht4x_set_poll_interval(&dev, 200);
+
+	int64_t start_us = esp_timer_get_time();
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_execute(&dev, cmd, &temp_ticks,
+			&hum_ticks));
+
+	int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+	/* The simulated sensor answers at the typical execution time */
+	TEST_ASSERT_TRUE(elapsed_us >= sht4x_get_command_typical_us(cmd));
+	TEST_ASSERT_EQUAL_UINT16(SIM_TEMP_TICKS, temp_ticks);
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_deinit(&dev));
+}
+
+#if CONFIG_SHT4X_HEATER
+static void test_heater_duty_cycle_is_enforced(void) {
+	uint16_t temp_ticks = 0;
+	uint16_t hum_ticks = 0;
+	const uint8_t cmd = SHT4X_ACTIVATE_LOWEST_HEATER_POWER_SHORT_TICKS_CMD;
+
+	start_device();
+
+	TEST_ASSERT_TRUE(sht4x_is_heater_command(cmd));
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_execute(&dev, cmd, &temp_ticks,
+			&hum_ticks));
+	TEST_ASSERT_BITS_HIGH(SHT4X_RECORD_FLAG_HEATER,
+			sht4x_get_result_flags(&dev));
+
+	/* A second pulse right away exceeds the duty cycle and is not sent */
+	uint32_t writes = sim.writes;
+
+	TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, sht4x_execute(&dev, cmd,
+			&temp_ticks, &hum_ticks));
+	TEST_ASSERT_EQUAL_UINT32(writes, sim.writes);
+
+	/* Measurements are still allowed and flagged as recovering */
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_execute(&dev,
+			SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD, &temp_ticks, &hum_ticks));
+	TEST_ASSERT_BITS_HIGH(SHT4X_RECORD_FLAG_HEATER_RECOVERY,
+			sht4x_get_result_flags(&dev));
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_deinit(&dev));
+}
+#endif /* CONFIG_SHT4X_HEATER */
+
+static void start_device(void) {
+	sht4x_transport_t transport;
+
+	sht4x_sim_init(&sim, SIM_TEMP_TICKS, SIM_HUM_TICKS, SIM_SERIAL);
+	sht4x_sim_get_transport(&sim, &transport);
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_init_with_transport(&dev, &transport));
+}
+
+static void set_faults(uint32_t nack_every, uint32_t crc_every,
+		                   uint32_t timeout_every) {
+	const sht4x_sim_faults_t faults = {
+			.nack_every = nack_every,
+			.crc_every = crc_every,
+			.timeout_every = timeout_every
+	};
+
+	sim.transactions = 0;
+	sim.writes = 0;
+	sim.reads = 0;
+	sht4x_sim_set_faults(&sim, &faults);
+}
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function to run the driver tests against the simulated sensor
+ */
+void test_sht4x_run(void) {
+	RUN_TEST(test_measure_returns_sensor_ticks);
+	RUN_TEST(test_unknown_command_is_rejected);
+	RUN_TEST(test_serial_number_is_cached);
+	RUN_TEST(test_crc_failure_is_reported);
+	RUN_TEST(test_nack_is_reported);
+	RUN_TEST(test_timeout_is_reported);
+	RUN_TEST(test_polling_returns_the_result);
+#if CONFIG_SHT4X_HEATER
+	RUN_TEST(test_heater_duty_cycle_is_enforced);
+#endif
+}
+
+/***************************** END OF FILE ************************************/
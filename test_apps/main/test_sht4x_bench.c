@@ -0,0 +1,209 @@
+/**
+  ******************************************************************************
+  * @file           : test_sht4x_bench.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : Throughput and cost benchmarks
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+
+#include "unity.h"
+
+#include "esp_timer.h"
+
+#include "sht4x.h"
+#include "sht4x_convert.h"
+#include "sht4x_scheduler.h"
+#include "sht4x_sim.h"
+#include "test_sht4x.h"
+
+/* Private macros ------------------------------------------------------------*/
+#define FRAMES_NUM		1000
+#define SAMPLES_NUM		50
+#define SWEEPS_NUM		10
+#define DEVS_NUM			4
+
+/* Private variables ---------------------------------------------------------*/
+static sht4x_frame_t frames[FRAMES_NUM];
+static sht4x_record_t records[FRAMES_NUM];
+static sht4x_sim_t sims[DEVS_NUM];
+static sht4x_t devs[DEVS_NUM];
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that initializes a simulated sensor and an instance on it
+ *
+ * @param index : Index of the simulated sensor and instance
+ */
+static void start_device(size_t index);
+
+/* Private function definitions ----------------------------------------------*/
+static void bench_crc(void) {
+	for (size_t i = 0; i < FRAMES_NUM; i++) {
+		uint16_t words[2] = {(uint16_t)(i * 61), (uint16_t)(i * 37)};
+
+		for (uint8_t j = 0; j < 2; j++) {
+			frames[i].data[j * 3] = (uint8_t)(words[j] >> 8);
+			frames[i].data[j * 3 + 1] = (uint8_t)words[j];
+			frames[i].data[j * 3 + 2] = sht4x_crc8(&frames[i].data[j * 3], 2);
+		}
+	}
+
+	int64_t start = esp_timer_get_time();
+	size_t valid = sht4x_check_frames(frames, FRAMES_NUM, NULL);
+	int64_t elapsed = esp_timer_get_time() - start;
+
+	TEST_ASSERT_EQUAL(FRAMES_NUM, valid);
+	printf("CRC: %d frames in %lld us, %.3f us per frame\n", FRAMES_NUM,
+			(long long)elapsed, (double)elapsed / FRAMES_NUM);
+}
+
+#if CONFIG_SHT4X_FLOAT_API
+static void bench_convert(void) {
+	static float temp[FRAMES_NUM];
+	static float hum[FRAMES_NUM];
+
+	for (size_t i = 0; i < FRAMES_NUM; i++) {
+		records[i] = (sht4x_record_t) {
+				.temp_ticks = (uint16_t)(i * 61),
+				.hum_ticks = (uint16_t)(i * 37)
+		};
+	}
+
+	int64_t start = esp_timer_get_time();
+	sht4x_convert_records(records, FRAMES_NUM, temp, hum);
+	int64_t elapsed = esp_timer_get_time() - start;
+
+	printf("Convert: %d records in %lld us, %.3f us per record\n", FRAMES_NUM,
+			(long long)elapsed, (double)elapsed / FRAMES_NUM);
+}
+#endif /* CONFIG_SHT4X_FLOAT_API */
+
+static void bench_execute(void) {
+	uint16_t temp_ticks = 0;
+	uint16_t hum_ticks = 0;
+
+	start_device(0);
+
+	int64_t start = esp_timer_get_time();
+
+	for (size_t i = 0; i < SAMPLES_NUM; i++) {
+		TEST_ASSERT_EQUAL(ESP_OK, sht4x_execute(&devs[0],
+				SHT4X_MEASURE_LOWEST_PRECISION_TICKS_CMD, &temp_ticks, &hum_ticks));
+	}
+
+	int64_t elapsed = esp_timer_get_time() - start;
+
+	printf("Execute: %d samples in %lld us, %.1f samples/s\n", SAMPLES_NUM,
+			(long long)elapsed, SAMPLES_NUM * 1e6 / (double)elapsed);
+
+#if CONFIG_SHT4X_STATS
+	sht4x_stats_t stats;
+
+	sht4x_get_stats(&devs[0], &stats);
+	TEST_ASSERT_EQUAL_UINT32(SAMPLES_NUM, stats.commands);
+	printf("Execute: latency min %u avg %u max %u us, bus %.1f us per sample\n",
+			(unsigned)stats.latency_min_us, (unsigned)stats.latency_avg_us,
+			(unsigned)stats.latency_max_us,
+			(double)stats.bus_time_us / SAMPLES_NUM);
+#endif
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_deinit(&devs[0]));
+}
+
+static void bench_sweep(void) {
+	sht4x_t *devs_ptr[DEVS_NUM];
+	sht4x_scheduler_t scheduler;
+	const sht4x_record_t *results = NULL;
+
+	for (size_t i = 0; i < DEVS_NUM; i++) {
+		start_device(i);
+		devs_ptr[i] = &devs[i];
+	}
+
+	const sht4x_scheduler_config_t config = {
+			.devs = devs_ptr,
+			.devs_num = DEVS_NUM,
+			.cmd = SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD,
+			.cb = NULL,
+			.cb_arg = NULL,
+			.queue = NULL
+	};
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_scheduler_init(&scheduler, &config));
+
+	int64_t start = esp_timer_get_time();
+
+	for (size_t i = 0; i < SWEEPS_NUM; i++) {
+		TEST_ASSERT_EQUAL(ESP_OK, sht4x_scheduler_sweep(&scheduler, &results));
+	}
+
+	int64_t elapsed = esp_timer_get_time() - start;
+
+	TEST_ASSERT_NOT_NULL(results);
+	printf("Sweep: %d devices in %.1f us per sweep, typical conversion %u us\n",
+			DEVS_NUM, (double)elapsed / SWEEPS_NUM,
+			(unsigned)sht4x_get_command_typical_us(
+					SHT4X_MEASURE_HIGH_PRECISION_TICKS_CMD));
+
+	sht4x_scheduler_deinit(&scheduler);
+
+	for (size_t i = 0; i < DEVS_NUM; i++) {
+		TEST_ASSERT_EQUAL(ESP_OK, sht4x_deinit(&devs[i]));
+	}
+}
+
+static void start_device(size_t index) {
+	sht4x_transport_t transport;
+
+	sht4x_sim_init(&sims[index], 26214, 32768, 0x12345678 + index);
+	sht4x_sim_get_transport(&sims[index], &transport);
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_init_with_transport(&devs[index],
+			&transport));
+}
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function to run the benchmarks. They only fail if the driver does,
+ * the figures are printed for comparison between builds.
+ */
+void test_sht4x_bench_run(void) {
+	RUN_TEST(bench_crc);
+#if CONFIG_SHT4X_FLOAT_API
+	RUN_TEST(bench_convert);
+#endif
+	RUN_TEST(bench_execute);
+	RUN_TEST(bench_sweep);
+}
+
+/***************************** END OF FILE ************************************/
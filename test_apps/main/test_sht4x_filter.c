@@ -0,0 +1,131 @@
+/**
+  ******************************************************************************
+  * @file           : test_sht4x_filter.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : Tick filter tests
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+
+#include "unity.h"
+
+#include "sht4x_filter.h"
+#include "test_sht4x.h"
+
+#if CONFIG_SHT4X_FILTER
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that feeds samples to a filter and checks every output
+ *
+ * @param filter      : Pointer to an initialized sht4x_filter_t instance
+ * @param in          : Samples fed to the filter
+ * @param expected    : Outputs expected after each sample
+ * @param samples_num : Number of samples
+ */
+static void check_outputs(sht4x_filter_t *filter, const uint16_t *in,
+		                      const uint16_t *expected, size_t samples_num);
+
+/* Private function definitions ----------------------------------------------*/
+static void test_filter_box(void) {
+	sht4x_filter_t filter;
+	const uint16_t in[] = {100, 200, 300, 400, 500};
+	const uint16_t expected[] = {100, 150, 200, 250, 350};
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_filter_init(&filter, SHT4X_FILTER_BOX, 4));
+	check_outputs(&filter, in, expected, sizeof(in) / sizeof(in[0]));
+
+	/* A reset filter starts over from the next sample */
+	sht4x_filter_reset(&filter);
+	TEST_ASSERT_EQUAL_UINT16(1000, sht4x_filter_update(&filter, 1000));
+}
+
+static void test_filter_ema(void) {
+	sht4x_filter_t filter;
+	const uint16_t in[] = {1000, 2000, 2000, 0};
+	const uint16_t expected[] = {1000, 1500, 1750, 875};
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_filter_init(&filter, SHT4X_FILTER_EMA, 1));
+	check_outputs(&filter, in, expected, sizeof(in) / sizeof(in[0]));
+}
+
+static void test_filter_median(void) {
+	sht4x_filter_t filter;
+	const uint16_t in[] = {10, 1000, 20, 30, 5000};
+	const uint16_t expected[] = {10, 505, 20, 30, 30};
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_filter_init(&filter, SHT4X_FILTER_MEDIAN,
+			3));
+	check_outputs(&filter, in, expected, sizeof(in) / sizeof(in[0]));
+}
+
+static void test_filter_none_passes_samples_through(void) {
+	sht4x_filter_t filter;
+	const uint16_t in[] = {7, 65535, 0};
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_filter_init(&filter, SHT4X_FILTER_NONE, 0));
+	check_outputs(&filter, in, in, sizeof(in) / sizeof(in[0]));
+}
+
+static void test_filter_rejects_bad_parameters(void) {
+	sht4x_filter_t filter;
+
+	TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, sht4x_filter_init(&filter,
+			SHT4X_FILTER_BOX, 0));
+	TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, sht4x_filter_init(&filter,
+			SHT4X_FILTER_MEDIAN, SHT4X_FILTER_WINDOW_MAX + 1));
+	TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, sht4x_filter_init(&filter,
+			SHT4X_FILTER_EMA, 16));
+}
+
+static void check_outputs(sht4x_filter_t *filter, const uint16_t *in,
+		                      const uint16_t *expected, size_t samples_num) {
+	for (size_t i = 0; i < samples_num; i++) {
+		TEST_ASSERT_EQUAL_UINT16(expected[i], sht4x_filter_update(filter, in[i]));
+	}
+}
+#endif /* CONFIG_SHT4X_FILTER */
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function to run the tick filter tests
+ */
+void test_sht4x_filter_run(void) {
+#if CONFIG_SHT4X_FILTER
+	RUN_TEST(test_filter_box);
+	RUN_TEST(test_filter_ema);
+	RUN_TEST(test_filter_median);
+	RUN_TEST(test_filter_none_passes_samples_through);
+	RUN_TEST(test_filter_rejects_bad_parameters);
+#endif
+}
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,183 @@
+/**
+  ******************************************************************************
+  * @file           : test_sht4x_history.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : Reading history tests
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2026 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdlib.h>
+
+#include "unity.h"
+
+#include "sht4x_history.h"
+#include "test_sht4x.h"
+
+#if CONFIG_SHT4X_HISTORY
+/* Private macros ------------------------------------------------------------*/
+#define READINGS_NUM	300
+#define PERIOD_US			1000000LL
+
+/* Private variables ---------------------------------------------------------*/
+static sht4x_record_t in[READINGS_NUM];
+static sht4x_record_t out[READINGS_NUM];
+
+/* Private function prototypes -----------------------------------------------*/
+/**
+ * @brief Function that fills in[] with a random walk sampled with jitter
+ *
+ * @param readings_num : Number of readings
+ * @param jitter_us    : Maximum timestamp error of a reading
+ */
+static void make_readings(size_t readings_num, int64_t jitter_us);
+
+/* Private function definitions ----------------------------------------------*/
+static void test_history_round_trip(void) {
+	sht4x_history_t history;
+	sht4x_history_config_t config = SHT4X_HISTORY_CONFIG_DEFAULT();
+	/* Periods are stored in ms, rounding adds up to half a ms of error */
+	const int64_t tolerance_us = config.time_tolerance_ms * 1000LL + 500;
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_history_init(&history, &config));
+
+	make_readings(READINGS_NUM, config.time_tolerance_ms * 500LL);
+
+	for (size_t i = 0; i < READINGS_NUM; i++) {
+		TEST_ASSERT_EQUAL(ESP_OK, sht4x_history_append(&history, &in[i]));
+	}
+
+	/* Read back in chunks that do not line up with the blocks */
+	size_t got = 0;
+	size_t n = 0;
+
+	while ((n = sht4x_history_read(&history, &out[got], 7)) > 0) {
+		got += n;
+		TEST_ASSERT_LESS_OR_EQUAL(READINGS_NUM, got);
+	}
+
+	TEST_ASSERT_EQUAL(READINGS_NUM, got);
+	TEST_ASSERT_EQUAL_UINT32(0, sht4x_history_get_dropped(&history));
+
+	for (size_t i = 0; i < READINGS_NUM; i++) {
+		TEST_ASSERT_EQUAL_UINT16(in[i].temp_ticks, out[i].temp_ticks);
+		TEST_ASSERT_EQUAL_UINT16(in[i].hum_ticks, out[i].hum_ticks);
+		TEST_ASSERT_EQUAL_UINT8(in[i].flags, out[i].flags);
+		TEST_ASSERT_TRUE(llabs(in[i].timestamp_us - out[i].timestamp_us) <=
+				tolerance_us);
+	}
+
+	sht4x_history_deinit(&history);
+}
+
+static void test_history_pop_and_decode_block(void) {
+	sht4x_history_t history;
+	sht4x_history_config_t config = SHT4X_HISTORY_CONFIG_DEFAULT();
+	sht4x_history_block_t block;
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_history_init(&history, &config));
+
+	make_readings(10, 0);
+
+	for (size_t i = 0; i < 10; i++) {
+		TEST_ASSERT_EQUAL(ESP_OK, sht4x_history_append(&history, &in[i]));
+	}
+
+	/* Readings already read are returned again by the block decoder */
+	TEST_ASSERT_EQUAL(3, sht4x_history_read(&history, out, 3));
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_history_pop_block(&history, &block));
+	TEST_ASSERT_EQUAL(10, sht4x_history_decode_block(&block, out,
+			READINGS_NUM));
+
+	for (size_t i = 0; i < 10; i++) {
+		TEST_ASSERT_EQUAL_UINT16(in[i].temp_ticks, out[i].temp_ticks);
+		TEST_ASSERT_EQUAL_UINT16(in[i].hum_ticks, out[i].hum_ticks);
+		TEST_ASSERT_TRUE(in[i].timestamp_us == out[i].timestamp_us);
+	}
+
+	TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, sht4x_history_pop_block(&history,
+			&block));
+
+	sht4x_history_deinit(&history);
+}
+
+static void test_history_rejects_failed_readings(void) {
+	sht4x_history_t history;
+	sht4x_history_config_t config = SHT4X_HISTORY_CONFIG_DEFAULT();
+	const sht4x_record_t record = {
+			.timestamp_us = PERIOD_US,
+			.status = SHT4X_ERR_CRC
+	};
+
+	TEST_ASSERT_EQUAL(ESP_OK, sht4x_history_init(&history, &config));
+	TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, sht4x_history_append(&history,
+			&record));
+	TEST_ASSERT_EQUAL(0, sht4x_history_read(&history, out, READINGS_NUM));
+
+	sht4x_history_deinit(&history);
+}
+
+static void make_readings(size_t readings_num, int64_t jitter_us) {
+	int32_t temp_ticks = 26000;
+	int32_t hum_ticks = 30000;
+
+	srand(1);
+
+	for (size_t i = 0; i < readings_num; i++) {
+		int64_t jitter = jitter_us > 0 ?
+				(rand() % (2 * jitter_us + 1)) - jitter_us : 0;
+
+		temp_ticks += rand() % 41 - 20;
+		hum_ticks += rand() % 121 - 60;
+
+		in[i] = (sht4x_record_t) {
+				.timestamp_us = PERIOD_US * (int64_t)(i + 1) + jitter,
+				.temp_ticks = (uint16_t)temp_ticks,
+				.hum_ticks = (uint16_t)hum_ticks,
+				.status = ESP_OK,
+				.flags = i % 50 == 7 ? SHT4X_RECORD_FLAG_HEATER : 0
+		};
+	}
+}
+#endif /* CONFIG_SHT4X_HISTORY */
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function to run the reading history tests
+ */
+void test_sht4x_history_run(void) {
+#if CONFIG_SHT4X_HISTORY
+	RUN_TEST(test_history_round_trip);
+	RUN_TEST(test_history_pop_and_decode_block);
+	RUN_TEST(test_history_rejects_failed_readings);
+#endif
+}
+
+/***************************** END OF FILE ************************************/